@@ -3,24 +3,77 @@
 #include <stdio.h>
 #include <string.h>
 
-Boggler3::Boggler3(TrieT* t) : dict_(t) {}
-Boggler3::~Boggler3() { delete dict_; }
+// Skip the neighbors of a cell when none of their letters continue the word.
+// On 3x3 the DFS is so small that computing the masks costs more than it saves.
+static const bool PruneByNeighborLetters = false;
+
+// The explicit-stack DFS (BoggleSolver::IterativeSearch) is ~40% slower than
+// the unrolled recursive one on 3x3 boards; see 3x3/perf_test.
+static const bool IterativeByDefault = false;
+
+// Prefetching the children of each cell's neighbors is ~13% slower on 3x3,
+// where there's less to hide the latency behind; see 3x3/perf_test.
+static const bool PrefetchByDefault = false;
+
+Boggler3::Boggler3(TrieT* t) : dict_(t), words_(NULL) {
+  SetIterativeDFS(IterativeByDefault);
+  SetPrefetchChildren(PrefetchByDefault);
+  FindNeighbors(3, 3, neighbors_, num_neighbors_);
+}
+Boggler3::~Boggler3() {
+  delete words_;
+  delete dict_;
+}
+
+const char* Boggler3::Word(int word_id) {
+  if (!words_) words_ = new WordTable(dict_);
+  return words_->Word(word_id);
+}
 
 void Boggler3::SetCell(int x, int y, int c) { bd_[x*3 + y] = c; }
 int Boggler3::Cell(int x, int y) const { return bd_[x*3 + y]; }
 
 int Boggler3::InternalScore() {
+  return Search<false>();
+}
+
+int Boggler3::InternalScoreAtLeast(int threshold) {
+  threshold_ = threshold;
+  return Search<true>();
+}
+
+void Boggler3::ResetMarks() {
+  TrieUtils<TrieT>::SetAllMarks(dict_, 0);
+}
+
+void Boggler3::InternalScoreDictionaries(int* scores) {
+  ScoreDictionariesOnBoard(dict_, bd_, 9, neighbors_, num_neighbors_, scores);
+}
+
+template<bool EarlyExit>
+int Boggler3::Search() {
   used_ = 0;
   score_ = 0;
+  if (PruneByNeighborLetters)
+    NeighborLetterMasks(9, bd_, neighbors_, num_neighbors_, nbr_mask_);
+  if (iterative_) {
+    score_ = IterativeSearch<EarlyExit>(
+        dict_, bd_, 9, neighbors_, num_neighbors_,
+        PruneByNeighborLetters ? nbr_mask_ : NULL, threshold_);
+    return score_;
+  }
   for (int i = 0; i < 9; i++) {
+    if (EarlyExit && score_ >= threshold_) break;
     int c = bd_[i];
     if (dict_->StartsWord(c))
-      DoDFS(i, 0, dict_->Descend(c));
+      DoDFS<EarlyExit>(i, 0, dict_->Descend(c));
   }
   return score_;
 }
 
+template<bool EarlyExit>
 void Boggler3::DoDFS(int i, int len, TrieT* t) {
+  if (EarlyExit && score_ >= threshold_) return;
   int c = bd_[i];
 
   used_ ^= (1 << i);
@@ -32,6 +85,13 @@ void Boggler3::DoDFS(int i, int len, TrieT* t) {
     }
   }
 
+  if (PruneByNeighborLetters && (t->ChildMask() & nbr_mask_[i]) == 0) {
+    used_ ^= (1 << i);
+    return;
+  }
+  if (prefetch_)
+    PrefetchNeighbors(t, i, used_, bd_, neighbors_, num_neighbors_);
+
   // Could also get rid of any two dimensionality, but maybe GCC does that?
   int cc, idx;
 
@@ -40,7 +100,7 @@ void Boggler3::DoDFS(int i, int len, TrieT* t) {
                       if ((used_ & (1 << idx)) == 0) { \
                         cc = bd_[(x)*3+(y)]; \
                         if (t->StartsWord(cc)) { \
-                          DoDFS((x)*3+(y), len, t->Descend(cc)); \
+                          DoDFS<EarlyExit>((x)*3+(y), len, t->Descend(cc)); \
                         } \
                       } \
 		 } while(0)
@@ -19,15 +19,17 @@ class Boggler3 : public BoggleSolver {
   Boggler3(TrieT* t);
   virtual ~Boggler3();
 
-  // TODO(danvk): add to BoggleSolver
-  // Find the actual words on the board.
-  // void FindWords(bool annotate, std::set<std::string>* out);
-
   // Set a cell on the current board. Must have 0 <= x, y < 4 and 0 <= c < 26.
   // These constraints are NOT checked.
   void SetCell(int x, int y, int c);
   int Cell(int x, int y) const;
 
+  // Reports each word on the current board to v->FoundWord(); see
+  // WordVisitor in boggle_solver.h. Visitor needn't be a WordVisitor.
+  template<class Visitor> void FindWords(Visitor* v);
+  virtual void FindWords(WordVisitor* v) { FindWords<WordVisitor>(v); }
+  virtual const char* Word(int word_id);
+
   int Width() const { return 3; }
   int Height() const { return 3; }
 
@@ -37,13 +39,30 @@ class Boggler3 : public BoggleSolver {
 
  protected:
   int InternalScore();
+  int InternalScoreAtLeast(int threshold);
+  void ResetMarks();
+  void InternalScoreDictionaries(int* scores);
 
  private:
-  void DoDFS(int i, int len, TrieT* t);
+  // With EarlyExit, the search is abandoned once score_ >= threshold_.
+  template<bool EarlyExit> int Search();
+  template<bool EarlyExit> void DoDFS(int i, int len, TrieT* t);
   TrieT* dict_;
+  WordTable* words_;  // built on the first call to FindWords().
   mutable unsigned int used_;
   mutable int bd_[9];
   unsigned int score_;
+  int threshold_;
+  int neighbors_[9][8];
+  int num_neighbors_[9];
+  uint32_t nbr_mask_[9];  // letters on the neighbors of each cell.
 };
 
+template<class Visitor>
+void Boggler3::FindWords(Visitor* v) {
+  if (!words_) words_ = new WordTable(dict_);
+  NextRun();
+  FindWordsOnBoard(dict_, bd_, 9, neighbors_, num_neighbors_, v);
+}
+
 #endif
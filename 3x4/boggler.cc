@@ -5,24 +5,76 @@
 
 static const bool PrintWords  = false;
 
-Boggler34::Boggler34(TrieT* t) : dict_(t) {}
-Boggler34::~Boggler34() { delete dict_; }
+// Skip the neighbors of a cell when none of their letters continue the word.
+static const bool PruneByNeighborLetters = true;
+
+// On 3x4 the explicit-stack DFS (BoggleSolver::IterativeSearch) and the
+// recursive one are within the noise of each other; see 3x4/perf_test.
+static const bool IterativeByDefault = false;
+
+// Prefetching the children of each cell's neighbors hasn't been repeatably
+// faster on 3x4; see 3x4/perf_test.
+static const bool PrefetchByDefault = false;
+
+Boggler34::Boggler34(TrieT* t) : dict_(t), words_(NULL) {
+  SetIterativeDFS(IterativeByDefault);
+  SetPrefetchChildren(PrefetchByDefault);
+  FindNeighbors(3, 4, neighbors_, num_neighbors_);
+}
+Boggler34::~Boggler34() {
+  delete words_;
+  delete dict_;
+}
+
+const char* Boggler34::Word(int word_id) {
+  if (!words_) words_ = new WordTable(dict_);
+  return words_->Word(word_id);
+}
 
 void Boggler34::SetCell(int x, int y, int c) { bd_[x*4 + y] = c; }
 int Boggler34::Cell(int x, int y) const { return bd_[x*4 + y]; }
 
 int Boggler34::InternalScore() {
+  return Search<false>();
+}
+
+int Boggler34::InternalScoreAtLeast(int threshold) {
+  threshold_ = threshold;
+  return Search<true>();
+}
+
+void Boggler34::ResetMarks() {
+  TrieUtils<TrieT>::SetAllMarks(dict_, 0);
+}
+
+void Boggler34::InternalScoreDictionaries(int* scores) {
+  ScoreDictionariesOnBoard(dict_, bd_, 12, neighbors_, num_neighbors_, scores);
+}
+
+template<bool EarlyExit>
+int Boggler34::Search() {
   used_ = 0;
   score_ = 0;
+  if (PruneByNeighborLetters)
+    NeighborLetterMasks(12, bd_, neighbors_, num_neighbors_, nbr_mask_);
+  if (iterative_) {
+    score_ = IterativeSearch<EarlyExit>(
+        dict_, bd_, 12, neighbors_, num_neighbors_,
+        PruneByNeighborLetters ? nbr_mask_ : NULL, threshold_);
+    return score_;
+  }
   for (int i = 0; i < 12; i++) {
+    if (EarlyExit && score_ >= threshold_) break;
     int c = bd_[i];
     if (dict_->StartsWord(c))
-      DoDFS(i, 0, dict_->Descend(c));
+      DoDFS<EarlyExit>(i, 0, dict_->Descend(c));
   }
   return score_;
 }
 
+template<bool EarlyExit>
 void Boggler34::DoDFS(int i, int len, TrieT* t) {
+  if (EarlyExit && score_ >= threshold_) return;
   int c = bd_[i];
 
   used_ ^= (1 << i);
@@ -38,6 +90,13 @@ void Boggler34::DoDFS(int i, int len, TrieT* t) {
     }
   }
 
+  if (PruneByNeighborLetters && (t->ChildMask() & nbr_mask_[i]) == 0) {
+    used_ ^= (1 << i);
+    return;
+  }
+  if (prefetch_)
+    PrefetchNeighbors(t, i, used_, bd_, neighbors_, num_neighbors_);
+
   // Could also get rid of any two dimensionality, but maybe GCC does that?
   int cc, idx;
 
@@ -54,7 +113,7 @@ void Boggler34::DoDFS(int i, int len, TrieT* t) {
       if ((used_ & (1 << idx)) == 0) {
         cc = bd_[idx];
         if (t->StartsWord(cc)) {
-          DoDFS(idx, len, t->Descend(cc));
+          DoDFS<EarlyExit>(idx, len, t->Descend(cc));
         }
       }
     }
@@ -0,0 +1,115 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <map>
+#include "mtrandom/randomc.h"
+#include "test.h"
+#include "boggle_solver.h"
+#include "perf_counter.h"
+
+double secs();
+
+typedef TRandomMersenne Random;
+
+const unsigned int prime = (1 << 20) - 3;
+
+// The ways the solvers can do their DFS.
+struct DFSMode {
+  const char* name;
+  bool iterative;
+  bool prefetch;
+};
+const DFSMode kModes[] = {
+  { "Recursive", false, false },
+  { "Recursive+prefetch", false, true },
+  { "Iterative", true, false },
+};
+const int kNumModes = sizeof(kModes) / sizeof(*kModes);
+
+void PrintMode(const DFSMode& mode, const DFSMode& default_mode,
+               double bds_per_sec, bool have_misses, double misses_per_bd) {
+  bool is_default = (mode.iterative == default_mode.iterative &&
+                     mode.prefetch == default_mode.prefetch);
+  printf("%s DFS%s: %lf bds/sec", mode.name, is_default ? " (default)" : "",
+         bds_per_sec);
+  if (have_misses) printf(", %.1f cache misses/bd", misses_per_bd);
+  printf("\n");
+}
+
+// Scores reps random boards and returns a hash of their scores.
+unsigned int HashRandomBoards(BoggleSolver* solver, int reps,
+                              unsigned int* total_score) {
+  Random r(0xb0881e);
+  unsigned int hash = 1234;
+  for (int rep = 0; rep < reps; rep++) {
+    unsigned int a = r.BRandom();
+    unsigned int b = r.BRandom();
+    uint64_t c = ((uint64_t)(a) << 32) + b;
+    for (unsigned int x = 0; x < 3; x++) {
+      for (unsigned int y = 0; y < 4; y++) {
+        solver->SetCell(x, y, c % 26);
+        c = c / 26;
+      }
+    }
+
+    int score = solver->Score();
+    hash *= (123 + score);
+    hash = hash % prime;
+    *total_score += score;
+  }
+  return hash;
+}
+
+int main(int argc, char** argv) {
+  BoggleSolver* solver = BoggleSolver::Create(34, "words");
+
+  unsigned int total_score = 0;
+  unsigned int hash;
+  unsigned int reps = 1000000;
+
+  double start = secs();
+  hash = HashRandomBoards(solver, reps, &total_score);
+  double end = secs();
+  printf("Total score: %u = %lf pts/bd\n",
+      total_score, 1.0 * total_score / solver->NumBoards());
+  printf("Score hash: 0x%08X\n", hash);
+  printf("Evaluated %llu boards in %lf seconds = %lf bds/sec\n",
+      (unsigned long long)solver->NumBoards(), (end-start),
+      solver->NumBoards()/(end-start));
+
+  // Compare the versions of the DFS. The solver uses whichever is fastest by
+  // default. Cache misses are counted if the kernel allows it.
+  const DFSMode default_mode =
+      { "", solver->IterativeDFS(), solver->PrefetchChildren() };
+  CacheMissCounter misses;
+  if (!misses.Available())
+    printf("Not counting cache misses (%s)\n", misses.Error().c_str());
+  for (int m = 0; m < kNumModes; m++) {
+    const DFSMode& mode = kModes[m];
+    solver->SetIterativeDFS(mode.iterative);
+    solver->SetPrefetchChildren(mode.prefetch);
+    unsigned int dfs_score = 0;
+    misses.Start();
+    start = secs();
+    unsigned int dfs_hash = HashRandomBoards(solver, reps, &dfs_score);
+    end = secs();
+    uint64_t num_misses = misses.Stop();
+    if (dfs_hash != hash) {
+      fprintf(stderr, "%s DFS hash mismatch: 0x%08X != 0x%08X\n",
+              mode.name, dfs_hash, hash);
+      return 1;
+    }
+    PrintMode(mode, default_mode, reps / (end - start), misses.Available(),
+              1.0 * num_misses / reps);
+  }
+
+  printf("%s: All tests passed!\n", argv[0]);
+  return 0;
+}
+
+double secs() {
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
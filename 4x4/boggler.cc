@@ -1,27 +1,89 @@
 #include "4x4/boggler.h"
 
+#include <ctype.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+#include <utility>
 
 static const bool PrintWords  = false;
 
-Boggler::Boggler(TrieT* t) : dict_(t) {}
-Boggler::~Boggler() { delete dict_; }
+// Skip the neighbors of a cell when none of their letters continue the word.
+static const bool PruneByNeighborLetters = true;
+
+// The explicit-stack DFS (BoggleSolver::IterativeSearch) is ~40% slower than
+// the unrolled recursive one on 4x4 boards; see perf_test.
+static const bool IterativeByDefault = false;
+
+// Prefetching the children of each cell's neighbors helps ~6% on random
+// boards, but costs ~10% on perf_test's boards, where the Trie is mostly in
+// cache already. The latter is more like what anneal and hill_climb score.
+static const bool PrefetchByDefault = false;
+
+Boggler::Boggler(TrieT* t) : dict_(t), words_(NULL) {
+  SetIterativeDFS(IterativeByDefault);
+  SetPrefetchChildren(PrefetchByDefault);
+  FindNeighbors(4, 4, neighbors_, num_neighbors_);
+}
+Boggler::~Boggler() {
+  delete words_;
+  delete dict_;
+}
+
+const char* Boggler::Word(int word_id) {
+  if (!words_) words_ = new WordTable(dict_);
+  return words_->Word(word_id);
+}
 
 void Boggler::SetCell(int x, int y, int c) { bd_[(x << 2) + y] = c; }
 int Boggler::Cell(int x, int y) const { return bd_[(x << 2) + y]; }
 
 int Boggler::InternalScore() {
+  return Search<false>();
+}
+
+int Boggler::InternalScoreAtLeast(int threshold) {
+  threshold_ = threshold;
+  return Search<true>();
+}
+
+void Boggler::ResetMarks() {
+  TrieUtils<TrieT>::SetAllMarks(dict_, 0);
+}
+
+void Boggler::InternalScoreDictionaries(int* scores) {
+  ScoreDictionariesOnBoard(dict_, bd_, 16, neighbors_, num_neighbors_, scores);
+}
+
+template<bool EarlyExit>
+int Boggler::Search() {
   used_ = 0;
   score_ = 0;
+  if (PruneByNeighborLetters)
+    NeighborLetterMasks(16, bd_, neighbors_, num_neighbors_, nbr_mask_);
+  if (iterative_) {
+    score_ = IterativeSearch<EarlyExit>(
+        dict_, bd_, 16, neighbors_, num_neighbors_,
+        PruneByNeighborLetters ? nbr_mask_ : NULL, threshold_);
+    return score_;
+  }
   for (int i = 0; i < 16; i++) {
+    if (EarlyExit && score_ >= threshold_) break;
     int c = bd_[i];
     if (dict_->StartsWord(c))
-      DoDFS(i, 0, dict_->Descend(c));
+      DoDFS<EarlyExit>(i, 0, dict_->Descend(c));
   }
   return score_;
 }
 
+template<bool EarlyExit>
 void Boggler::DoDFS(int i, int len, TrieT* t) {
+  if (EarlyExit && score_ >= threshold_) return;
   int c = bd_[i];
 
   used_ ^= (1 << i);
@@ -37,6 +99,13 @@ void Boggler::DoDFS(int i, int len, TrieT* t) {
     }
   }
 
+  if (PruneByNeighborLetters && (t->ChildMask() & nbr_mask_[i]) == 0) {
+    used_ ^= (1 << i);
+    return;
+  }
+  if (prefetch_)
+    PrefetchNeighbors(t, i, used_, bd_, neighbors_, num_neighbors_);
+
   // Could also get rid of any two dimensionality, but maybe GCC does that?
   int cc, idx;
 
@@ -45,7 +114,7 @@ void Boggler::DoDFS(int i, int len, TrieT* t) {
                       if ((used_ & (1 << idx)) == 0) { \
                         cc = bd_[(x)*4+(y)]; \
                         if (t->StartsWord(cc)) { \
-                          DoDFS((x)*4+(y), len, t->Descend(cc)); \
+                          DoDFS<EarlyExit>((x)*4+(y), len, t->Descend(cc)); \
                         } \
                       } \
 		 } while(0)
@@ -84,20 +153,121 @@ void Boggler::DoDFS(int i, int len, TrieT* t) {
 
 // TODO(danvk): figure out a way to move this into BoggleSolver.
 Boggler::TrieT* Boggler::DictionaryFromFile(const char* filename) {
-  TrieT* t = new TrieT;
-  char line[80];
-  FILE* f = fopen(filename, "r");
-  if (!f) {
-    fprintf(stderr, "Couldn't open %s\n", filename);
-    // delete t;  // ARGH
+  return DictionaryFromFiles(std::vector<std::string>(1, filename));
+}
+
+namespace {
+
+// A word in a memory-mapped dictionary file. It's not null-terminated.
+struct MappedWord {
+  const char* start;
+  int len;
+  int dictionary;
+};
+
+// Words longer than this can't be Boggle words, even with a "qu".
+const int kMaxWordLen = 17;
+
+// Builds the Tries below the root for the letters taken from *next_letter.
+// words[c] holds the words which start with letter c, and the Trie for their
+// remaining letters goes in subtries[c]. Its nodes come from arena, which
+// belongs to this thread.
+void AddWords(const std::vector<MappedWord>* words,
+              std::atomic<int>* next_letter, SimpleTrie** subtries,
+              SimpleTrie::Arena* arena) {
+  char word[kMaxWordLen + 1];
+  for (int c; (c = next_letter->fetch_add(1)) < kNumLetters; ) {
+    SimpleTrie* t = NULL;
+    for (int i = 0; i < words[c].size(); i++) {
+      const MappedWord& w = words[c][i];
+      memcpy(word, w.start, w.len);
+      word[w.len] = '\0';
+      if (!BoggleSolver::BogglifyWord(word)) continue;
+      if (!t) t = arena->NewNode();
+      t->AddWord(word + 1)->AddDictionary(w.dictionary);
+    }
+    subtries[c] = t;
+  }
+}
+
+}  // namespace
+
+Boggler::TrieT* Boggler::DictionaryFromFiles(
+    const std::vector<std::string>& filenames, int num_threads) {
+  if (filenames.size() > TrieT::kMaxDictionaries) {
+    fprintf(stderr, "Can't merge more than %d dictionaries\n",
+            TrieT::kMaxDictionaries);
     return NULL;
   }
 
-  while (!feof(f) && fscanf(f, "%s", line)) {
-    if (!BogglifyWord(line)) continue;
-    t->AddWord(line);
+  // Map in every file and sort its words by first letter. Words which are
+  // too long or don't start with a lowercase letter can be dropped here.
+  std::vector<std::pair<void*, size_t> > maps;
+  std::vector<MappedWord> words[kNumLetters];
+  bool ok = true;
+  for (int d = 0; d < filenames.size() && ok; d++) {
+    int fd = open(filenames[d].c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+      fprintf(stderr, "Couldn't open %s\n", filenames[d].c_str());
+      if (fd >= 0) close(fd);
+      ok = false;
+      break;
+    }
+    size_t size = st.st_size;
+    if (size == 0) {
+      close(fd);
+      continue;
+    }
+    void* mem = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+      fprintf(stderr, "Couldn't map %s\n", filenames[d].c_str());
+      ok = false;
+      break;
+    }
+    maps.push_back(std::make_pair(mem, size));
+
+    const char* p = (const char*)mem;
+    const char* end = p + size;
+    while (p < end) {
+      while (p < end && isspace((unsigned char)*p)) p++;
+      const char* start = p;
+      while (p < end && !isspace((unsigned char)*p)) p++;
+      int len = p - start;
+      if (len == 0 || len > kMaxWordLen) continue;
+      if (*start < 'a' || *start > 'z') continue;
+      MappedWord w = { start, len, d };
+      words[*start - 'a'].push_back(w);
+    }
+  }
+
+  TrieT* t = NULL;
+  if (ok) {
+    t = new TrieT;
+    SimpleTrie* subtries[kNumLetters];
+    std::atomic<int> next_letter(0);
+    if (num_threads <= 0) num_threads = std::thread::hardware_concurrency();
+    if (num_threads > kNumLetters) num_threads = kNumLetters;
+    if (num_threads <= 1) {
+      AddWords(words, &next_letter, subtries, t->GetArena());
+    } else {
+      // Each thread gets its own Arena, which the root takes over.
+      std::vector<std::thread> threads;
+      for (int i = 0; i < num_threads; i++) {
+        SimpleTrie::Arena* arena = new SimpleTrie::Arena;
+        t->GetArena()->Adopt(arena);
+        threads.push_back(std::thread(AddWords, words, &next_letter, subtries,
+                                      arena));
+      }
+      for (int i = 0; i < num_threads; i++) threads[i].join();
+    }
+
+    for (int c = 0; c < kNumLetters; c++) {
+      if (subtries[c]) t->SetChild(c, subtries[c]);
+    }
   }
-  fclose(f);
 
+  for (int i = 0; i < maps.size(); i++) munmap(maps[i].first, maps[i].second);
   return t;
 }
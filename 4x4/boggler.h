@@ -2,6 +2,8 @@
 #ifndef BOGGLER_4
 #define BOGGLER_4
 
+#include <string>
+#include <vector>
 #include "boggle_solver.h"
 #include "trie.h"
 
@@ -20,6 +22,12 @@ class Boggler : public BoggleSolver {
   void SetCell(int x, int y, int c);  // { bd_[(x << 2) + y] = c; }
   int Cell(int x, int y) const;  // { return bd_[(x << 2) + y]; }
 
+  // Reports each word on the current board to v->FoundWord(); see
+  // WordVisitor in boggle_solver.h. Visitor needn't be a WordVisitor.
+  template<class Visitor> void FindWords(Visitor* v);
+  virtual void FindWords(WordVisitor* v) { FindWords<WordVisitor>(v); }
+  virtual const char* Word(int word_id);
+
   int Width() const { return 4; }
   int Height() const { return 4; }
 
@@ -27,17 +35,42 @@ class Boggler : public BoggleSolver {
 
   static TrieT* DictionaryFromFile(const char* filename);
 
+  // Merges several dictionaries into one Trie. Each word is marked with the
+  // dictionaries it's in, so that ScoreDictionaries() can tell them apart.
+  // There can be at most SimpleTrie::kMaxDictionaries of them.
+  // The files are mmap'd, and the Tries for words starting with each letter
+  // are built on num_threads threads (0 = one per core) and then joined.
+  static TrieT* DictionaryFromFiles(const std::vector<std::string>& filenames,
+                                    int num_threads = 0);
+
  protected:
   virtual int InternalScore();
+  virtual int InternalScoreAtLeast(int threshold);
+  virtual void ResetMarks();
+  virtual void InternalScoreDictionaries(int* scores);
 
  private:
-  void DoDFS(int i, int len, TrieT* t);
+  // With EarlyExit, the search is abandoned once score_ >= threshold_.
+  template<bool EarlyExit> int Search();
+  template<bool EarlyExit> void DoDFS(int i, int len, TrieT* t);
 
   TrieT* dict_;
+  WordTable* words_;  // built on the first call to FindWords().
   unsigned int used_;
   unsigned int cutoff_;
   int bd_[16];
   int score_;
+  int threshold_;
+  int neighbors_[16][8];
+  int num_neighbors_[16];
+  uint32_t nbr_mask_[16];  // letters on the neighbors of each cell.
 };
 
+template<class Visitor>
+void Boggler::FindWords(Visitor* v) {
+  if (!words_) words_ = new WordTable(dict_);
+  NextRun();
+  FindWordsOnBoard(dict_, bd_, 16, neighbors_, num_neighbors_, v);
+}
+
 #endif
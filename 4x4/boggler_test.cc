@@ -1,11 +1,218 @@
 #include <stdio.h>
 #include <unistd.h>
 
+#include <string>
+#include <vector>
 #include "test.h"
 #include "trie.h"
 #include "boggler.h"
 
+// Exposes runs_ so that it can be pushed to the point of wrapping around.
+class WrapBoggler : public Boggler {
+ public:
+  WrapBoggler(TrieT* t) : Boggler(t) {}
+  void SetRuns(uintptr_t runs) { runs_ = runs; }
+  uintptr_t Runs() const { return runs_; }
+};
+
+// Scores shouldn't be affected by marks left over from before a wraparound.
+void TestRunsWrap() {
+  SimpleTrie* t = new SimpleTrie;
+  t->AddWord("ate");
+  t->AddWord("tea");
+  t->AddWord("eta");
+  t->AddWord("eat");
+  WrapBoggler b(t);
+
+  CHECK_EQ(4, b.Score("texxaxxxyyyyzzzz"));  // marks the words with 1.
+  CHECK_EQ(1, b.Runs());
+
+  b.SetRuns(UINTPTR_MAX - 1);
+  CHECK_EQ(0, b.Score("zzzzzzzzzzzzzzzz"));
+  CHECK_EQ(UINTPTR_MAX, b.Runs());
+
+  // runs_ wraps around to 1 here. Unless the marks are cleared, all the
+  // words will look like they've already been found on this board.
+  CHECK_EQ(4, b.Score("texxaxxxyyyyzzzz"));
+  CHECK_EQ(1, b.Runs());
+  CHECK_EQ(4, b.Score("texxaxxxyyyyzzzz"));
+  CHECK_EQ(4, b.NumBoards());
+}
+
+// Records the words found by FindWords().
+struct WordCollector {
+  WordCollector() : points(0) {}
+  void FoundWord(int word_id, const int* path, int path_len, int pts) {
+    ids.push_back(word_id);
+    paths.push_back(std::vector<int>(path, path + path_len));
+    points += pts;
+  }
+  void VisitNode(const void* node) {}
+  std::vector<int> ids;
+  std::vector<std::vector<int> > paths;
+  int points;
+};
+
+void TestFindWords() {
+  SimpleTrie* t = new SimpleTrie;
+  t->AddWord("tea");
+  t->AddWord("teak");
+  t->AddWord("qat");  // "quat"
+  t->AddWord("zzz");
+  Boggler b(t);
+
+  // Cell i = 4 * x + y, so "teak" goes 0 -> 1 -> 4 -> 5.
+  const char* bd = "texxakxxqyyyzzzz";
+  int score = b.Score(bd);
+  WordCollector words;
+  b.FindWords(&words);
+  CHECK_EQ(score, words.points);
+  CHECK_EQ(4, words.ids.size());
+
+  // Ids are in alphabetical order.
+  CHECK_EQ("quat", std::string(b.Word(0)));
+  CHECK_EQ("tea", std::string(b.Word(1)));
+  CHECK_EQ("teak", std::string(b.Word(2)));
+  CHECK_EQ("zzz", std::string(b.Word(3)));
+  CHECK_IN(0, words.ids);
+  CHECK_IN(1, words.ids);
+  CHECK_IN(2, words.ids);
+  CHECK_IN(3, words.ids);
+
+  for (int i = 0; i < words.ids.size(); i++) {
+    std::string spelled;
+    for (int j = 0; j < words.paths[i].size(); j++) {
+      char c = bd[words.paths[i][j]];
+      spelled += (c == 'q' ? std::string("qu") : std::string(1, c));
+    }
+    CHECK_EQ(std::string(b.Word(words.ids[i])), spelled);
+  }
+
+  // The virtual interface finds the same words.
+  struct Counter : public WordVisitor {
+    Counter() : n(0) {}
+    void FoundWord(int word_id, const int* path, int path_len, int points) {
+      n += 1;
+    }
+    int n;
+  } counter;
+  BoggleSolver* solver = &b;
+  solver->FindWords(&counter);
+  CHECK_EQ(4, counter.n);
+}
+
+// Each dictionary's score from one search matches scoring it on its own.
+void TestScoreDictionaries() {
+  const char* kWords[][3] = {
+    { "tea", "eat", "teak" },  // dictionary 0
+    { "tea", "ate", "fiver" },  // dictionary 1
+  };
+  const char* kBoards[] = { "texxakxxyyyyzzzz", "fivxxxreyyyyzzzz" };
+  int solo[2][2];  // [dictionary][board]
+  SimpleTrie* merged = new SimpleTrie;
+  for (int d = 0; d < 2; d++) {
+    SimpleTrie* t = new SimpleTrie;
+    for (int i = 0; i < 3; i++) {
+      t->AddWord(kWords[d][i]);
+      merged->AddWord(kWords[d][i])->AddDictionary(d);
+    }
+    Boggler b(t);
+    for (int j = 0; j < 2; j++) solo[d][j] = b.Score(kBoards[j]);
+  }
+  CHECK_EQ(3, solo[0][0]);  // tea, eat, teak
+  CHECK_EQ(2, solo[1][0]);  // tea, ate
+  CHECK_EQ(0, solo[0][1]);
+  CHECK_EQ(2, solo[1][1]);  // fiver
+
+  Boggler m(merged);
+  m.SetNumDictionaries(2);
+  for (int j = 0; j < 2; j++) {
+    int scores[2];
+    CHECK(m.ScoreDictionaries(kBoards[j], scores));
+    CHECK_EQ(solo[0][j], scores[0]);
+    CHECK_EQ(solo[1][j], scores[1]);
+  }
+  CHECK_EQ(4, m.Score(kBoards[0]));  // all four words
+}
+
+// Loads dictionaries a word at a time, as DictionaryFromFiles used to.
+SimpleTrie* SimpleLoad(const std::vector<std::string>& files) {
+  SimpleTrie* t = new SimpleTrie;
+  char line[1000];
+  for (int d = 0; d < files.size(); d++) {
+    FILE* f = fopen(files[d].c_str(), "r");
+    while (fscanf(f, "%999s", line) == 1) {
+      if (!BoggleSolver::BogglifyWord(line)) continue;
+      t->AddWord(line)->AddDictionary(d);
+    }
+    fclose(f);
+  }
+  return t;
+}
+
+// Do a and b have the same words, in the same dictionaries?
+bool SameTrie(const SimpleTrie* a, const SimpleTrie* b) {
+  if (a->ChildMask() != b->ChildMask() || a->IsWord() != b->IsWord() ||
+      a->Dictionaries() != b->Dictionaries())
+    return false;
+  for (int i = 0; i < 26; i++) {
+    if (a->StartsWord(i) && !SameTrie(a->Descend(i), b->Descend(i)))
+      return false;
+  }
+  return true;
+}
+
+// The mmap'd, multi-threaded loader gets the same Trie as reading one word
+// at a time.
+void TestDictionaryFromFiles() {
+  char tmp_file[] = "/tmp/boggler-words.XXXXXX";
+  int fd = mkstemp(tmp_file);
+  CHECK(fd != -1);
+  FILE* f = fdopen(fd, "w");
+  fprintf(f, "tea\n  quate\r\nqat\tzzz Tea\n\n123 te\ncaf\xe9 \xa0zoo\n");
+  for (int i = 0; i < 200; i++) fputc('a', f);  // too long for a Boggle word
+  fprintf(f, "\nabcdefghijklmnoqu\nabcdefghijklmnopqr\nlast");  // no newline
+  fclose(f);
+
+  std::vector<std::string> files;
+  files.push_back(tmp_file);
+  SimpleTrie* expected = SimpleLoad(files);
+  CHECK_EQ(5, TrieUtils<SimpleTrie>::Size(expected));
+  for (int threads = 1; threads <= 4; threads += 3) {
+    SimpleTrie* t = Boggler::DictionaryFromFiles(files, threads);
+    CHECK(SameTrie(expected, t));
+    CHECK(NULL != TrieUtils<SimpleTrie>::FindWord(t, "qate"));
+    CHECK(NULL != TrieUtils<SimpleTrie>::FindWord(t, "abcdefghijklmnoq"));
+    CHECK(NULL != TrieUtils<SimpleTrie>::FindWord(t, "last"));
+    delete t;
+  }
+  delete expected;
+
+  files.push_back("/nonexistent/words");
+  CHECK(NULL == Boggler::DictionaryFromFiles(files));
+  CHECK_EQ(0, remove(tmp_file));
+
+  files.clear();
+  files.push_back("words");
+  files.push_back("twl.txt");
+  expected = SimpleLoad(files);
+  for (int threads = 1; threads <= 4; threads += 3) {
+    SimpleTrie* t = Boggler::DictionaryFromFiles(files, threads);
+    CHECK(SameTrie(expected, t));
+    // Every node belongs to the root, whichever thread made it.
+    CHECK(t->GetArena()->BytesAllocated() >=
+          TrieUtils<SimpleTrie>::NumNodes(t) * sizeof(SimpleTrie));
+    delete t;
+  }
+  delete expected;
+}
+
 int main(int argc, char** argv) {
+  TestRunsWrap();
+  TestFindWords();
+  TestScoreDictionaries();
+  TestDictionaryFromFiles();
+
   SimpleTrie* t = new SimpleTrie;
   t->AddWord("ate");
   t->AddWord("tea");
@@ -31,5 +238,45 @@ int main(int argc, char** argv) {
   CHECK_EQ(3, b.Score("sxxxixxxexxxrsxx"));
   CHECK_EQ(4, b.NumBoards());
 
+  // ScoreAtLeast agrees with Score(), whether or not it stops early.
+  CHECK(b.ScoreAtLeast("texxaxxxyyyyzzzz", 1));
+  CHECK(b.ScoreAtLeast("texxaxxxyyyyzzzz", 4));
+  CHECK(!b.ScoreAtLeast("texxaxxxyyyyzzzz", 5));
+  CHECK(b.ScoreAtLeast("texxakxxyyyyzzzz", 5));
+  CHECK(b.ScoreAtLeast("zzzzzzzzzzzzzzzz", 0));
+  CHECK(!b.ScoreAtLeast("zzzzzzzzzzzzzzzz", 1));
+  CHECK_EQ(4, b.Score("texxaxxxyyyyzzzz"));
+
+  // The recursive and iterative DFSs agree.
+  const bool iterative = b.IterativeDFS();
+  b.SetIterativeDFS(!iterative);
+  CHECK_EQ(4, b.Score("texxaxxxyyyyzzzz"));
+  CHECK_EQ(5, b.Score("texxakxxyyyyzzzz"));
+  CHECK_EQ(3, b.Score("sxxxixxxexxxrsxx"));
+  CHECK(b.ScoreAtLeast("texxaxxxyyyyzzzz", 4));
+  CHECK(!b.ScoreAtLeast("texxaxxxyyyyzzzz", 5));
+  CHECK(b.ScoreAtLeast("texxakxxyyyyzzzz", 1));
+  b.SetIterativeDFS(iterative);
+
+  // ...and prefetching doesn't change anything.
+  const bool prefetch = b.PrefetchChildren();
+  b.SetPrefetchChildren(!prefetch);
+  CHECK_EQ(5, b.Score("texxakxxyyyyzzzz"));
+  CHECK_EQ(3, b.Score("sxxxixxxexxxrsxx"));
+  b.SetPrefetchChildren(prefetch);
+
+  // Rotations and reflections of a board share a cache entry.
+  b.SetScoreCacheSize(100);
+  CHECK_EQ(0, b.CacheHits());
+  CHECK_EQ(5, b.Score("texxakxxyyyyzzzz"));
+  CHECK_EQ(0, b.CacheHits());
+  CHECK_EQ(1, b.CacheMisses());
+  CHECK_EQ(5, b.Score("texxakxxyyyyzzzy"));  // not a rotation
+  CHECK_EQ(2, b.CacheMisses());
+  CHECK_EQ(5, b.Score("zzzzyyyyxxkaxxet"));  // rotated 180 degrees
+  CHECK_EQ(1, b.CacheHits());
+  CHECK(b.ScoreAtLeast("xxetxxkayyyyzzzz", 5));  // flipped
+  CHECK_EQ(2, b.CacheHits());
+
   printf("%s: All tests passed!\n", argv[0]);
 }
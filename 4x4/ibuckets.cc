@@ -3,6 +3,8 @@
 #include <stdio.h>
 #include <algorithm>
 #include <iostream>
+#include <thread>
+#include <vector>
 using std::min;
 using std::max;
 
@@ -17,6 +19,11 @@ char* BucketSolver4::MutableCell(int idx) { return bd_[idx]; }
 const char* BucketSolver4::Cell(int idx) const { return bd_[idx]; }
 
 void BucketSolver4::InternalUpperBound(int bailout_score) {
+  if (bound_threads_ > 1 && NumPossibilities() >= bound_min_letters_) {
+    ParallelUpperBound(bound_threads_, bailout_score);
+    return;
+  }
+
   for (int i = 0; i < 16; i++) {
     int max_score = DoAllDescents(i, 0, dict_);
     details_.max_nomark += max_score;
@@ -27,6 +34,53 @@ void BucketSolver4::InternalUpperBound(int bailout_score) {
   }
 }
 
+// The start cells are handed out one at a time, since the middle ones take
+// much longer than the corners.
+void BucketSolver4::ParallelUpperBound(int num_threads, int bailout_score) {
+  std::vector<Worker> workers(num_threads);
+  std::atomic<int> next_cell(0), max_nomark(0);
+  std::atomic<bool> done(false);
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; i++) {
+    threads.push_back(std::thread(&BucketSolver4::RunWorker, this,
+                                  &workers[i], &next_cell, &max_nomark, &done,
+                                  bailout_score));
+  }
+  RunWorker(&workers[0], &next_cell, &max_nomark, &done, bailout_score);
+  for (int i = 0; i < threads.size(); i++) threads[i].join();
+
+  // Merge the words into the largest set, counting each one once.
+  int biggest = 0;
+  for (int i = 1; i < num_threads; i++) {
+    if (workers[i].words.size() > workers[biggest].words.size()) biggest = i;
+  }
+  Worker& all = workers[biggest];
+  for (int i = 0; i < num_threads; i++) {
+    if (i == biggest) continue;
+    for (std::unordered_map<SimpleTrie*, int>::const_iterator it =
+             workers[i].words.begin();
+         it != workers[i].words.end(); ++it) {
+      if (all.words.insert(*it).second) all.sum_union += it->second;
+    }
+  }
+  details_.max_nomark = max_nomark;
+  details_.sum_union = all.sum_union;
+}
+
+void BucketSolver4::RunWorker(Worker* w, std::atomic<int>* next_cell,
+                              std::atomic<int>* max_nomark,
+                              std::atomic<bool>* done, int bailout_score) {
+  w->used = 0;
+  w->sum_union = 0;
+  while (!*done) {
+    int i = (*next_cell)++;
+    if (i >= 16) break;
+    int nomark = (*max_nomark += ParallelDoAllDescents(i, 0, dict_, w));
+    // This thread's words are a subset of the union, so this is safe.
+    if (nomark > bailout_score && w->sum_union > bailout_score) *done = true;
+  }
+}
+
 int BucketSolver4::DoAllDescents(int idx, int len, SimpleTrie* t) {
   int max_score = 0;
   for (int j = 0; bd_[idx][j]; j++) {
@@ -72,3 +126,45 @@ int BucketSolver4::DoDFS(int i, int len, SimpleTrie* t) {
   used_ ^= (1 << i);
   return score;
 }
+
+int BucketSolver4::ParallelDoAllDescents(int idx, int len, SimpleTrie* t,
+                                         Worker* w) {
+  int max_score = 0;
+  for (int j = 0; bd_[idx][j]; j++) {
+    int cc = bd_[idx][j] - 'a';
+    if (t->StartsWord(cc)) {
+      int tscore = ParallelDoDFS(idx, len + (cc==kQ ? 2 : 1),
+                                 t->Descend(cc), w);
+      max_score = max(tscore, max_score);
+    }
+  }
+  return max_score;
+}
+
+int BucketSolver4::ParallelDoDFS(int i, int len, SimpleTrie* t, Worker* w) {
+  int score = 0;
+  w->used ^= (1 << i);
+
+  int x = i / 4, y = i % 4;
+  for (int dx = -1; dx <= 1; dx++) {
+    if (x + dx < 0 || x + dx > 3) continue;
+    for (int dy = -1; dy <= 1; dy++) {
+      if (y + dy < 0 || y + dy > 3) continue;
+      int idx = (x+dx) * 4 + y + dy;
+      if ((w->used & (1 << idx)) == 0) {
+        score += ParallelDoAllDescents(idx, len, t, w);
+      }
+    }
+  }
+
+  if (t->IsWord()) {
+    int word_score = kWordScores[len];
+    score += word_score;
+    if (w->words.insert(std::make_pair(t, word_score)).second) {
+      w->sum_union += word_score;
+    }
+  }
+
+  w->used ^= (1 << i);
+  return score;
+}
@@ -2,6 +2,8 @@
 #define IBUCKETS_44
 
 #include <limits.h>
+#include <atomic>
+#include <unordered_map>
 #include "bucket_solver.h"
 #include "trie.h"
 
@@ -20,9 +22,27 @@ class BucketSolver4 : public BucketSolver {
  private:
   virtual void InternalUpperBound(int bailout_score = INT_MAX);
 
+  // State for one thread of a parallel bound (see SetBoundThreads). Threads
+  // can't share used_ or the marks in the Trie, so each one keeps its own
+  // used cells and the words it has found. sum_union is the score of the
+  // union of the threads' words.
+  struct Worker {
+    int used;
+    int sum_union;
+    std::unordered_map<SimpleTrie*, int> words;  // word -> points
+  };
+  void ParallelUpperBound(int num_threads, int bailout_score);
+  void RunWorker(Worker* w, std::atomic<int>* next_cell,
+                 std::atomic<int>* max_nomark, std::atomic<bool>* done,
+                 int bailout_score);
+
   int DoAllDescents(int idx, int len, SimpleTrie* t);
   int DoDFS(int i, int len, SimpleTrie* t);
 
+  // The same, but with a Worker's state instead of used_ and the Trie marks.
+  int ParallelDoAllDescents(int idx, int len, SimpleTrie* t, Worker* w);
+  int ParallelDoDFS(int i, int len, SimpleTrie* t, Worker* w);
+
   char bd_[16][27];  // null-terminated lists of possible letters
 };
 
@@ -94,9 +94,43 @@ void TestBound() {
   CHECK_EQ(3, score);
 }
 
+// Splitting the start cells between threads gives the same bound.
+void TestParallelBound() {
+  SimpleTrie* t = Boggler::DictionaryFromFile("words");
+  BucketSolver4 bb(t);
+  const char* classes[] = {
+    "s e p z e a u z h t c z i c z z",
+    "st e a s e z z st a z z z z z z z",
+    "aeiou st chlnr aeiou st aeiou chlnr st chlnr aeiou st aeiou st chlnr "
+        "aeiou st",
+  };
+  for (int i = 0; i < sizeof(classes) / sizeof(*classes); i++) {
+    CHECK(bb.ParseBoard(classes[i]));
+    bb.SetBoundThreads(1);
+    int score = bb.UpperBound();
+    BucketSolver::ScoreDetails d = bb.Details();
+
+    bb.SetBoundThreads(3);
+    CHECK_EQ(score, bb.UpperBound());
+    CHECK_EQ(d.sum_union, bb.Details().sum_union);
+    CHECK_EQ(d.max_nomark, bb.Details().max_nomark);
+
+    // Too few letters to bother with threads.
+    bb.SetBoundThreads(3, 1000);
+    CHECK_EQ(score, bb.UpperBound());
+    CHECK_EQ(d.sum_union, bb.Details().sum_union);
+
+    // A bailout still gives a score above the bailout score.
+    bb.SetBoundThreads(3);
+    if (score > 10) CHECK(bb.UpperBound(10) > 10);
+  }
+  bb.SetBoundThreads(1);
+}
+
 int main(int argc, char** argv) {
   TestBoards();
   TestBound();
+  TestParallelBound();
 
   printf("%s: All tests passed!\n", argv[0]);
 }
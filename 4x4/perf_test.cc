@@ -8,13 +8,67 @@ const int reps = 10;
 #include <string.h>
 #include <sys/time.h>
 #include <map>
+#include <string>
+#include <vector>
 #include "test.h"
 #include "trie.h"
 #include "4x4/boggler.h"
+#include "family_scorer.h"
+#include "perf_counter.h"
 
 void TrieStats(const SimpleTrie& pt);
 double secs();
 
+const unsigned int prime = (1 << 20) - 3;
+
+// The ways the solvers can do their DFS.
+struct DFSMode {
+  const char* name;
+  bool iterative;
+  bool prefetch;
+};
+const DFSMode kModes[] = {
+  { "Recursive", false, false },
+  { "Recursive+prefetch", false, true },
+  { "Iterative", true, false },
+};
+const int kNumModes = sizeof(kModes) / sizeof(*kModes);
+
+void PrintMode(const DFSMode& mode, const DFSMode& default_mode,
+               double bds_per_sec, bool have_misses, double misses_per_bd) {
+  bool is_default = (mode.iterative == default_mode.iterative &&
+                     mode.prefetch == default_mode.prefetch);
+  printf("%s DFS%s: %lf bds/sec", mode.name, is_default ? " (default)" : "",
+         bds_per_sec);
+  if (have_misses) printf(", %.1f cache misses/bd", misses_per_bd);
+  printf("\n");
+}
+
+// Scores every variation of the bases in which one cell in the second column
+// and one in the third are changed, and returns a hash of the scores.
+unsigned int HashBoards(Boggler* b, const char** bases, int bds,
+                        unsigned int* total_score) {
+  unsigned int hash = 1234;
+  for (int i=0; i<bds; ++i) {
+    b->ParseBoard(bases[i]);
+    for (int y1 = 0; y1 < 4; y1++) {
+      for (int y2 = 0; y2 < 4; y2++) {
+        for (int c1 = 0; c1 < 26; c1++) {
+          b->SetCell(1, y1, c1);
+          for (int c2 = 0; c2 < 26; c2++) {
+            b->SetCell(2, y2, c2);
+            int score = b->Score();
+            hash *= (123 + score);
+            hash = hash % prime;
+            *total_score += score;
+          }
+        }
+      }
+    }
+  }
+  return hash;
+}
+
 int main(int argc, char** argv) {
   const char* dict_file;
   if (argc == 2) dict_file = argv[1];
@@ -29,7 +83,6 @@ int main(int argc, char** argv) {
   TrieStats(*st);
 
   Boggler b(st);
-  unsigned int prime = (1 << 20) - 3;
   unsigned int total_score = 0;
   unsigned int hash;
 
@@ -37,36 +90,89 @@ int main(int argc, char** argv) {
   int bds = sizeof(bases) / sizeof(*bases);
   double start = secs();
   for (int rep = 0; rep < reps; rep++) {
-    hash = 1234;
+    hash = HashBoards(&b, bases, bds, &total_score);
+    if (hash != 0x0000095C) {
+      fprintf(stderr, "Hash mismatch, expected 0x95C\n");
+      return 1;
+    }
+  }
+
+  double end = secs();
+  printf("Total score: %u = %lf pts/bd\n",
+      total_score, 1.0 * total_score / b.NumBoards());
+  printf("Score hash: 0x%08X\n", hash);
+  printf("Evaluated %llu boards in %lf seconds = %lf bds/sec\n",
+      (unsigned long long)b.NumBoards(), (end-start),
+      b.NumBoards()/(end-start));
+
+  // Score the same families with a FamilyScorer, which does the DFS through
+  // the fourteen fixed cells once per family rather than once per board. As
+  // above, free cells are left as 'z' after their family has been scored.
+  FamilyScorer fs(Boggler::DictionaryFromFile(dict_file), 4, 4);
+  std::vector<int> free_cells(2), scores;
+  int num_boards = 0;
+  unsigned int family_hash = 0;
+  start = secs();
+  for (int rep = 0; rep < reps; rep++) {
+    family_hash = 1234;
     for (int i=0; i<bds; ++i) {
-      b.ParseBoard(bases[i]);
+      std::string bd(bases[i]);
       for (int y1 = 0; y1 < 4; y1++) {
         for (int y2 = 0; y2 < 4; y2++) {
-          for (int c1 = 0; c1 < 26; c1++) {
-            b.SetCell(1, y1, c1);
-            for (int c2 = 0; c2 < 26; c2++) {
-              b.SetCell(2, y2, c2);
-              int score = b.Score();
-              hash *= (123 + score);
-              hash = hash % prime;
-              total_score += score;
-            }
+          free_cells[0] = 1*4 + y1;
+          free_cells[1] = 2*4 + y2;
+          fs.SetBase(bd.c_str(), free_cells);
+          fs.ScoreAll(&scores);
+          bd[free_cells[0]] = bd[free_cells[1]] = 'z';
+          for (int j = 0; j < scores.size(); j++) {
+            family_hash *= (123 + scores[j]);
+            family_hash = family_hash % prime;
           }
+          num_boards += scores.size();
         }
       }
     }
-    if (hash != 0x000C1D3D) {
-      fprintf(stderr, "Hash mismatch, expected 0xC1D3D\n");
+    if (family_hash != hash) {
+      fprintf(stderr, "FamilyScorer hash mismatch: 0x%08X != 0x%08X\n",
+              family_hash, hash);
       return 1;
     }
   }
+  end = secs();
+  printf("FamilyScorer: evaluated %d boards in %lf seconds = %lf bds/sec\n",
+      num_boards, (end-start), num_boards/(end-start));
+
+  // Compare the versions of the DFS. Boggler uses whichever is fastest by
+  // default. Cache misses are counted if the kernel allows it.
+  const DFSMode default_mode = { "", b.IterativeDFS(), b.PrefetchChildren() };
+  CacheMissCounter misses;
+  if (!misses.Available())
+    printf("Not counting cache misses (%s)\n", misses.Error().c_str());
+  for (int m = 0; m < kNumModes; m++) {
+    const DFSMode& mode = kModes[m];
+    b.SetIterativeDFS(mode.iterative);
+    b.SetPrefetchChildren(mode.prefetch);
+    uint64_t num_before = b.NumBoards();
+    unsigned int dfs_score = 0, dfs_hash = 0;
+    misses.Start();
+    start = secs();
+    for (int rep = 0; rep < reps; rep++) {
+      dfs_hash = HashBoards(&b, bases, bds, &dfs_score);
+    }
+    end = secs();
+    uint64_t num_misses = misses.Stop();
+    if (dfs_hash != hash) {
+      fprintf(stderr, "%s DFS hash mismatch: 0x%08X != 0x%08X\n",
+              mode.name, dfs_hash, hash);
+      return 1;
+    }
+    uint64_t num = b.NumBoards() - num_before;
+    PrintMode(mode, default_mode, num / (end - start), misses.Available(),
+              1.0 * num_misses / num);
+  }
+  b.SetIterativeDFS(default_mode.iterative);
+  b.SetPrefetchChildren(default_mode.prefetch);
 
-  double end = secs();
-  printf("Total score: %u = %lf pts/bd\n",
-      total_score, 1.0 * total_score / b.NumBoards());
-  printf("Score hash: 0x%08X\n", hash);
-  printf("Evaluated %d boards in %lf seconds = %lf bds/sec\n",
-      b.NumBoards(), (end-start), b.NumBoards()/(end-start));
   printf("%s: All tests passed!\n", argv[0]);
   return 0;
 }
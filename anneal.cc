@@ -48,6 +48,8 @@ DEFINE_string(dictionary, "words", "Path to dictionary of words");
 DEFINE_int32(size, 44, "Type of boggle board to use (MN = MxN)");
 
 DEFINE_int32(num_runs, 1, "Number of simulated annealing runs to do.");
+DEFINE_int32(score_cache_size, 0,
+             "Cache the scores of this many recent boards (0 = no cache).");
 
 typedef TRandomMersenne Random;
 
@@ -77,6 +79,7 @@ int main(int argc, char** argv) {
 
   BoggleSolver* solver =
     BoggleSolver::Create(FLAGS_size, FLAGS_dictionary.c_str());
+  solver->SetScoreCacheSize(FLAGS_score_cache_size);
 
   // TODO(danvk): sanity-check parameters
   Random r(FLAGS_rand_seed);
@@ -94,5 +97,9 @@ int main(int argc, char** argv) {
     printf("     changes: %d\n", annealer.FinalStats().changes);
     printf("   mutations: %d\n", annealer.FinalStats().mutations);
     printf("mutate_calls: %d\n", annealer.FinalStats().mutate_calls);
+    if (FLAGS_score_cache_size) {
+      printf("  cache hits: %llu\n", (unsigned long long)solver->CacheHits());
+      printf("cache misses: %llu\n", (unsigned long long)solver->CacheMisses());
+    }
   }
 }
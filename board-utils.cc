@@ -7,7 +7,28 @@
 #include <string>
 
 BoardUtils::BoardUtils(int w, int h, int num_classes)
-    : w_(w), h_(h), num_classes_(num_classes) {
+    : w_(w), h_(h), num_classes_(num_classes), num_syms_(0) {
+  if (w_ * h_ > kMaxCells) return;
+
+  // Run a board whose cells are their own indices through each symmetry.
+  // These are the same transforms GenerateAnalogues uses.
+  std::string id(w_ * h_, ' ');
+  for (int i = 0; i < w_ * h_; i++) id[i] = i;
+  std::vector<std::string> images;
+  images.push_back(id);
+  images.push_back(FlipLeftRight(id));
+  images.push_back(FlipTopBottom(images.back()));
+  images.push_back(FlipLeftRight(images.back()));
+  if (w_ == h_) {
+    images.push_back(Rotate90CW(id));
+    images.push_back(FlipLeftRight(images.back()));
+    images.push_back(FlipTopBottom(images.back()));
+    images.push_back(FlipLeftRight(images.back()));
+  }
+  num_syms_ = images.size();
+  for (int s = 0; s < num_syms_; s++) {
+    for (int i = 0; i < w_ * h_; i++) perms_[s][i] = images[s][i];
+  }
 }
 
 void BoardUtils::UsePartition(const std::vector<std::string>& letters) {
@@ -40,6 +61,211 @@ const std::string BoardUtils::BoardFromId(uint64_t id) {
   return out;
 }
 
+BoardUtils::Id128 BoardUtils::BoardId128(const std::string& board) {
+  if (board.size() != w_ * h_) return (Id128)-1;
+  // Do most of the work in 64-bit arithmetic: num_classes^8 fits easily.
+  const int n = w_ * h_;
+  const int split = n > 8 ? n - 8 : 0;
+  uint64_t hi = 0, lo = 0, lo_base = 1;
+  for (int i = 0; i < n; i++) {
+    if (board[i] < 'a' || board[i] >= 'a' + num_classes_)
+      return (Id128)-1;
+    if (i < split) {
+      hi = hi * num_classes_ + (board[i] - 'a');
+    } else {
+      lo = lo * num_classes_ + (board[i] - 'a');
+      lo_base *= num_classes_;
+    }
+  }
+  return (Id128)hi * lo_base + lo;
+}
+
+const std::string BoardUtils::BoardFromId128(Id128 id) {
+  const int n = w_ * h_;
+  const int split = n > 8 ? n - 8 : 0;
+  uint64_t lo_base = 1;
+  for (int i = split; i < n; i++) lo_base *= num_classes_;
+  uint64_t hi = id / lo_base;
+  uint64_t lo = id % lo_base;
+
+  std::string out(n, ' ');
+  for (int i = n - 1; i >= split; i--) {
+    out[i] = 'a' + lo % num_classes_;
+    lo /= num_classes_;
+  }
+  for (int i = split - 1; i >= 0; i--) {
+    out[i] = 'a' + hi % num_classes_;
+    hi /= num_classes_;
+  }
+  return out;
+}
+
+BoardUtils::Id128 BoardUtils::PackedId(const std::string& board) {
+  if (board.size() != w_ * h_ || num_classes_ > 32) return (Id128)-1;
+  Id128 id = 0;
+  for (int i = 0; i < board.size(); i++) {
+    if (board[i] < 'a' || board[i] >= 'a' + num_classes_)
+      return (Id128)-1;
+    id = (id << 5) | (board[i] - 'a');
+  }
+  return id;
+}
+
+const std::string BoardUtils::BoardFromPackedId(Id128 id) {
+  std::string out(w_ * h_, ' ');
+  for (int i = w_ * h_ - 1; i >= 0; i--) {
+    out[i] = 'a' + (int)(id & 31);
+    id >>= 5;
+  }
+  return out;
+}
+
+BoardUtils::Id128 BoardUtils::CanonicalPackedId(const std::string& board) {
+  if (board.size() != w_ * h_ || !num_syms_) return (Id128)-1;
+  char canonical[kMaxCells];
+  Unpack(CanonicalPack(board.c_str()), canonical);
+  return PackedId(std::string(canonical, w_ * h_));
+}
+
+void BoardUtils::PackedIdToBytes(Id128 id, uint8_t* out) const {
+  for (int i = PackedIdBytes() - 1; i >= 0; i--) {
+    out[i] = (uint8_t)(id & 0xff);
+    id >>= 8;
+  }
+}
+
+BoardUtils::Id128 BoardUtils::PackedIdFromBytes(const uint8_t* in) const {
+  Id128 id = 0;
+  for (int i = 0; i < PackedIdBytes(); i++) id = (id << 8) | in[i];
+  return id;
+}
+
+BoardUtils::Id128 BoardUtils::NumCanonicalBoards() const {
+  if (!num_syms_) return (Id128)-1;
+  // Average the number of boards fixed by each symmetry: num_classes to the
+  // number of cycles in its permutation.
+  Id128 total = 0;
+  for (int s = 0; s < num_syms_; s++) {
+    bool seen[kMaxCells] = { false };
+    Id128 fixed = 1;
+    for (int i = 0; i < w_ * h_; i++) {
+      if (seen[i]) continue;
+      for (int j = i; !seen[j]; j = perms_[s][j]) seen[j] = true;
+      fixed *= num_classes_;
+    }
+    total += fixed;
+  }
+  return total / num_syms_;
+}
+
+// Counts the boards which are fixed by a symmetry and all of whose images are
+// at least bd. The cells of each cycle of the symmetry share a variable, which
+// is narrowed to a range of classes as the images are compared with bd.
+struct BoardUtils::AtLeastCounter {
+  const BoardUtils* bu;
+  const int* bd;
+  int var[kMaxCells];  // cell -> variable
+  int lo[kMaxCells];
+  int hi[kMaxCells];
+  int num_vars;
+  int end;  // bd is all zeros from here on, which any image matches.
+
+  AtLeastCounter(const BoardUtils* bu, int fixed_by, const int* bd)
+      : bu(bu), bd(bd), num_vars(0) {
+    const int n = bu->w_ * bu->h_;
+    for (end = n; end > 0 && bd[end - 1] == 0; end--) {}
+    for (int i = 0; i < n; i++) var[i] = -1;
+    for (int i = 0; i < n; i++) {
+      if (var[i] != -1) continue;
+      for (int j = i; var[j] == -1; j = bu->perms_[fixed_by][j])
+        var[j] = num_vars;
+      lo[num_vars] = 0;
+      hi[num_vars] = bu->num_classes_ - 1;
+      num_vars++;
+    }
+  }
+
+  // Compares cell t of each image s which still matches bd up to t. Images
+  // which can't be less than bd any more are dropped from tied.
+  Id128 Count(int t, int s, uint32_t tied) {
+    for (;; s++) {
+      if (s == bu->num_syms_) { s = 0; t++; }
+      if (!tied || t == end) {
+        Id128 count = 1;
+        for (int v = 0; v < num_vars; v++) count *= hi[v] - lo[v] + 1;
+        return count;
+      }
+      if (tied & (1 << s)) break;
+    }
+
+    const int v = var[bu->perms_[s][t]];
+    const int c = bd[t];
+    if (hi[v] < c) return 0;
+    if (lo[v] > c) return Count(t, s + 1, tied & ~(1 << s));
+
+    // Either this cell matches bd, or it's more, and the image is larger.
+    const int old_lo = lo[v], old_hi = hi[v];
+    lo[v] = hi[v] = c;
+    Id128 count = Count(t, s + 1, tied);
+    if (c < old_hi) {
+      lo[v] = c + 1;
+      hi[v] = old_hi;
+      count += Count(t, s + 1, tied & ~(1 << s));
+    }
+    lo[v] = old_lo;
+    hi[v] = old_hi;
+    return count;
+  }
+};
+
+BoardUtils::Id128 BoardUtils::ClassesBefore(const int* bd) const {
+  // A class's canonical board is >= bd iff all of its boards are. Those
+  // boards form a set which the symmetries map to itself, so Burnside's lemma
+  // counts its classes.
+  Id128 fixed = 0;
+  for (int s = 0; s < num_syms_; s++) {
+    AtLeastCounter counter(this, s, bd);
+    fixed += counter.Count(0, 0, (1 << num_syms_) - 1);
+  }
+  return NumCanonicalBoards() - fixed / num_syms_;
+}
+
+BoardUtils::Id128 BoardUtils::CanonicalRank(const std::string& board) {
+  if (board.size() != w_ * h_ || !num_syms_) return (Id128)-1;
+  std::string canonical = Canonicalize(board);
+  int bd[kMaxCells];
+  for (int i = 0; i < w_ * h_; i++) {
+    if (canonical[i] < 'a' || canonical[i] >= 'a' + num_classes_)
+      return (Id128)-1;
+    bd[i] = canonical[i] - 'a';
+  }
+  return ClassesBefore(bd);
+}
+
+const std::string BoardUtils::BoardFromCanonicalRank(Id128 rank) {
+  if (!num_syms_ || rank >= NumCanonicalBoards()) return "";
+  // The board is the largest one with no more than rank classes before it.
+  // Find it a cell at a time, with the later cells at their smallest.
+  const int n = w_ * h_;
+  int bd[kMaxCells] = { 0 };
+  for (int i = 0; i < n; i++) {
+    int lo = 0, hi = num_classes_ - 1;
+    while (lo < hi) {
+      bd[i] = (lo + hi + 1) / 2;
+      if (ClassesBefore(bd) <= rank) {
+        lo = bd[i];
+      } else {
+        hi = bd[i] - 1;
+      }
+    }
+    bd[i] = lo;
+  }
+
+  std::string out(n, ' ');
+  for (int i = 0; i < n; i++) out[i] = 'a' + bd[i];
+  return out;
+}
+
 bool BoardUtils::GenerateAnalogues(const std::string& board,
                                    std::vector<std::string>* analogues) {
   if (board.size() != w_ * h_) return false;
@@ -96,6 +322,7 @@ std::string BoardUtils::Rotate90CW(const std::string& bd) {
 
 bool BoardUtils::IsCanonical(const std::string& board) {
   if (board.size() != w_ * h_) return false;
+  if (num_syms_) return Pack(board.c_str()) == CanonicalPack(board.c_str());
   std::string bd;
   bd = FlipLeftRight(board); if (bd < board) return false;
   bd = FlipTopBottom(bd);    if (bd < board) return false;
@@ -111,6 +338,12 @@ bool BoardUtils::IsCanonical(const std::string& board) {
 }
 
 std::string BoardUtils::Canonicalize(const std::string& board) {
+  if (num_syms_ && board.size() == w_ * h_) {
+    std::string out(w_ * h_, ' ');
+    Unpack(CanonicalPack(board.c_str()), &out[0]);
+    return out;
+  }
+
   std::vector<std::string> rots;
   if (!GenerateAnalogues(board, &rots)) return "";
   rots.push_back(board);
@@ -118,6 +351,34 @@ std::string BoardUtils::Canonicalize(const std::string& board) {
   return rots[0];
 }
 
+BoardUtils::PackedBoard BoardUtils::Pack(const char* bd) const {
+  PackedBoard packed = 0;
+  for (int i = 0; i < w_ * h_; i++) packed = (packed << 8) | (uint8_t)bd[i];
+  return packed;
+}
+
+void BoardUtils::Unpack(PackedBoard packed, char* bd) const {
+  for (int i = w_ * h_ - 1; i >= 0; i--) {
+    bd[i] = (char)(packed & 0xff);
+    packed >>= 8;
+  }
+}
+
+BoardUtils::PackedBoard BoardUtils::CanonicalPack(const char* bd) const {
+  const int n = w_ * h_;
+  uint8_t cells[kMaxCells];
+  for (int i = 0; i < n; i++) cells[i] = bd[i];
+
+  PackedBoard best = ~(PackedBoard)0;
+  for (int s = 0; s < num_syms_; s++) {
+    const int* perm = perms_[s];
+    PackedBoard packed = 0;
+    for (int i = 0; i < n; i++) packed = (packed << 8) | cells[perm[i]];
+    best = packed < best ? packed : best;
+  }
+  return best;
+}
+
 int BoardUtils::Id(int x, int y) { return y * w_ + x; }
 int BoardUtils::X(int id) { return id % w_; }
 int BoardUtils::Y(int id) { return id / w_; }
@@ -17,12 +17,63 @@ class BoardUtils {
   uint64_t BoardId(const std::string& board);
   const std::string BoardFromId(uint64_t id);
 
+  // 128-bit versions of the above, which work for full 26-letter 4x4 boards.
+  // Ids are dense: 0 <= id < num_classes^(w*h). Returns -1 for a bad board.
+  typedef unsigned __int128 Id128;
+  Id128 BoardId128(const std::string& board);
+  const std::string BoardFromId128(Id128 id);
+
+  // Pack five bits per cell, with cell 0 in the high bits so that ids sort in
+  // the same order as the boards. A 4x4 board needs 80 bits, or ten bytes.
+  // Returns -1 for a bad board (or if there are more than 32 classes).
+  Id128 PackedId(const std::string& board);
+  const std::string BoardFromPackedId(Id128 id);
+
+  // The packed id of the canonical rotation/reflection of the board. All
+  // boards in a symmetry class share this id.
+  Id128 CanonicalPackedId(const std::string& board);
+
+  // Serialize packed ids as PackedIdBytes() big-endian bytes.
+  int PackedIdBytes() const { return (5 * w_ * h_ + 7) / 8; }
+  void PackedIdToBytes(Id128 id, uint8_t* out) const;
+  Id128 PackedIdFromBytes(const uint8_t* in) const;
+
+  // The number of symmetry classes of boards, by Burnside's lemma.
+  Id128 NumCanonicalBoards() const;
+
+  // Dense ranks for symmetry classes: 0 <= rank < NumCanonicalBoards(), in
+  // the order of the classes' canonical boards. All boards in a class share a
+  // rank. Classes are counted with Burnside's lemma rather than listed, so
+  // these work for full 26-letter 4x4 boards: a rank takes ~0.25ms, and
+  // finding the board for a rank ~15ms. Returns -1 (or "") for a bad board or
+  // rank.
+  Id128 CanonicalRank(const std::string& board);
+  const std::string BoardFromCanonicalRank(Id128 rank);
+
   // Returns true if the board is in the "canonoical" rotation/reflection.
   bool IsCanonical(const std::string& board);
 
   // Returns the canonical version of the board (possibly the input board).
   std::string Canonicalize(const std::string& board);
 
+  // Fast, allocation-free canonicalization for boards with <= kMaxCells cells.
+  // A board is packed one byte per cell with cell 0 in the most significant
+  // position, so comparing packed boards is the same as comparing strings.
+  typedef unsigned __int128 PackedBoard;
+  static const int kMaxCells = 16;
+  PackedBoard Pack(const char* bd) const;
+  void Unpack(PackedBoard packed, char* bd) const;  // does not null-terminate
+
+  // Returns the least of the board's symmetric images, packed.
+  PackedBoard CanonicalPack(const char* bd) const;
+
+  // Number of symmetries (including the identity): 8 if square, 4 otherwise.
+  int NumSymmetries() const { return num_syms_; }
+
+  // Symmetry(s)[i] is the cell which lands on cell i under symmetry s.
+  // Symmetry(0) is the identity.
+  const int* Symmetry(int s) const { return perms_[s]; }
+
   // Generates all boards in the same symmetry class.
   bool GenerateAnalogues(const std::string& board,
                          std::vector<std::string>* analogues);
@@ -49,6 +100,15 @@ class BoardUtils {
   int h_;
   int num_classes_;
   std::vector<std::string> classes_;
+
+  // perms_[s][i] is the cell which lands on cell i under symmetry s.
+  int num_syms_;
+  int perms_[8][kMaxCells];
+
+  // The number of classes whose canonical board sorts before bd, which has
+  // one class index (0 <= bd[i] < num_classes) per cell.
+  Id128 ClassesBefore(const int* bd) const;
+  struct AtLeastCounter;
 };
 
 #endif
@@ -32,6 +32,114 @@ void TestIdentity() {
   }
 }
 
+void TestIds128() {
+  std::string bd;
+  BoardUtils bu(4, 4);
+
+  // These don't fit in 64 bits.
+  bd = "zzzzzzzzzzzzzzzz";
+  BoardUtils::Id128 max_id = 1;
+  for (int i = 0; i < 16; i++) max_id *= 26;
+  CHECK(max_id - 1 == bu.BoardId128(bd));
+  CHECK_EQ(bd, bu.BoardFromId128(bu.BoardId128(bd)));
+  CHECK(0 == bu.BoardId128("aaaaaaaaaaaaaaaa"));
+  CHECK((BoardUtils::Id128)-1 == bu.BoardId128("abc"));
+
+  srand(4321);
+  uint8_t bytes[10];
+  CHECK_EQ(10, bu.PackedIdBytes());
+  std::string prev;
+  for (int n = 0; n < 1000; n++) {
+    bd = std::string(16, ' ');
+    for (int i = 0; i < 16; i++) bd[i] = 'a' + rand() % 26;
+    CHECK_EQ(bd, bu.BoardFromId128(bu.BoardId128(bd)));
+    CHECK_EQ(bd, bu.BoardFromPackedId(bu.PackedId(bd)));
+
+    bu.PackedIdToBytes(bu.PackedId(bd), bytes);
+    CHECK(bu.PackedId(bd) == bu.PackedIdFromBytes(bytes));
+
+    // Both kinds of ids sort like the boards do.
+    if (!prev.empty()) {
+      CHECK_EQ(prev < bd, bu.BoardId128(prev) < bu.BoardId128(bd));
+      CHECK_EQ(prev < bd, bu.PackedId(prev) < bu.PackedId(bd));
+    }
+    prev = bd;
+
+    // Agrees with the 64-bit version when that one fits.
+    std::string small = "aaaaaa" + bd.substr(0, 10);
+    CHECK(bu.BoardId(small) == bu.BoardId128(small));
+  }
+
+  std::vector<std::string> bds;
+  bu.GenerateAnalogues("abcdefghijklmnop", &bds);
+  for (int i = 0; i < bds.size(); i++) {
+    CHECK(bu.PackedId("abcdefghijklmnop") == bu.CanonicalPackedId(bds[i]));
+  }
+}
+
+// Ranks of canonical boards count up from zero with no gaps.
+void TestCanonicalRanks() {
+  int dims[][3] = { {3, 3, 2}, {3, 3, 3}, {3, 4, 2}, {4, 3, 2} };
+  for (int d = 0; d < 4; d++) {
+    BoardUtils bu(dims[d][0], dims[d][1], dims[d][2]);
+    // List the canonical boards, in order.
+    int n = dims[d][0] * dims[d][1];
+    std::string bd(n, 'a');
+    std::vector<std::string> canonical;
+    for (;;) {
+      if (bu.IsCanonical(bd)) canonical.push_back(bd);
+      int i = n - 1;
+      for (; i >= 0 && ++bd[i] == 'a' + dims[d][2]; i--) bd[i] = 'a';
+      if (i < 0) break;
+    }
+
+    CHECK(canonical.size() == bu.NumCanonicalBoards());
+    for (int r = 0; r < canonical.size(); r++) {
+      CHECK_EQ(canonical[r], bu.BoardFromCanonicalRank(r));
+      CHECK(r == bu.CanonicalRank(canonical[r]));
+    }
+    CHECK_EQ("", bu.BoardFromCanonicalRank(canonical.size()));
+  }
+
+  // Known counts: 102 two-color and 2862 three-color 3x3 boards.
+  CHECK(102 == BoardUtils(3, 3, 2).NumCanonicalBoards());
+  CHECK(2862 == BoardUtils(3, 3, 3).NumCanonicalBoards());
+
+  // Full 4x4 boards.
+  BoardUtils bu(4, 4);
+  BoardUtils::Id128 all = 1;
+  for (int i = 0; i < 16; i++) all *= 26;
+  BoardUtils::Id128 num = bu.NumCanonicalBoards();
+  CHECK(num > all / 8);
+  CHECK(num < all / 7);
+  CHECK(0 == bu.CanonicalRank("aaaaaaaaaaaaaaaa"));
+  CHECK(num - 1 == bu.CanonicalRank("zzzzzzzzzzzzzzzz"));
+  CHECK_EQ("zzzzzzzzzzzzzzzz", bu.BoardFromCanonicalRank(num - 1));
+  CHECK((BoardUtils::Id128)-1 == bu.CanonicalRank("abc"));
+
+  srand(2468);
+  std::vector<std::string> bds;
+  std::string prev;
+  BoardUtils::Id128 prev_rank = 0;
+  for (int n = 0; n < 100; n++) {
+    std::string bd(16, ' ');
+    for (int i = 0; i < 16; i++) bd[i] = 'a' + rand() % (n % 2 ? 3 : 26);
+    std::string canonical = bu.Canonicalize(bd);
+    BoardUtils::Id128 rank = bu.CanonicalRank(bd);
+    CHECK(rank < num);
+    CHECK_EQ(canonical, bu.BoardFromCanonicalRank(rank));
+
+    // Every board in a class has the same rank, and ranks sort like the
+    // canonical boards do.
+    bu.GenerateAnalogues(bd, &bds);
+    for (int i = 0; i < bds.size(); i++)
+      CHECK(rank == bu.CanonicalRank(bds[i]));
+    if (!prev.empty()) CHECK_EQ(prev < canonical, prev_rank < rank);
+    prev = canonical;
+    prev_rank = rank;
+  }
+}
+
 void TestFlips() {
   std::string bd;
   {
@@ -89,6 +197,33 @@ void TestAnalogues() {
   }
 }
 
+// The packed canonicalization should agree with sorting all the analogues.
+void TestCanonicalize() {
+  int dims[][2] = { {4, 4}, {3, 3}, {3, 4}, {4, 3} };
+  srand(1234);
+  for (int d = 0; d < 4; d++) {
+    BoardUtils bu(dims[d][0], dims[d][1]);
+    CHECK_EQ(dims[d][0] == dims[d][1] ? 8 : 4, bu.NumSymmetries());
+    std::vector<std::string> bds;
+    for (int n = 0; n < 1000; n++) {
+      // Use few letters so that plenty of boards have symmetries.
+      std::string bd(dims[d][0] * dims[d][1], ' ');
+      int num_letters = (n % 2 ? 3 : 26);
+      for (int i = 0; i < bd.size(); i++) bd[i] = 'a' + rand() % num_letters;
+
+      bu.GenerateAnalogues(bd, &bds);
+      bds.push_back(bd);
+      std::sort(bds.begin(), bds.end());
+      CHECK_EQ(bds[0], bu.Canonicalize(bd));
+      CHECK_EQ(bds[0] == bd, bu.IsCanonical(bd));
+
+      std::string unpacked(bd.size(), ' ');
+      bu.Unpack(bu.Pack(bd.c_str()), &unpacked[0]);
+      CHECK_EQ(bd, unpacked);
+    }
+  }
+}
+
 void TestExpand() {
   {
     BoardUtils bu(3, 2);
@@ -106,8 +241,11 @@ void TestExpand() {
 
 int main(int argc, const char** argv) {
   TestIdentity();
+  TestIds128();
+  TestCanonicalRanks();
   TestFlips();
   TestAnalogues();
+  TestCanonicalize();
   TestExpand();
   printf("%s: All tests passed!\n", argv[0]);
 }
@@ -6,20 +6,47 @@
 #include "3x3/boggler.h"
 #include "3x4/boggler.h"
 #include "4x4/boggler.h"
+#include "board-utils.h"
+#include "dafsa.h"
+#include "dafsa_boggler.h"
 #include "trie.h"
 
 const int BoggleSolver::kWordScores[] =
       //0, 1, 2, 3, 4, 5, 6, 7,  8,  9, 10, 11, 12, 13, 14, 15, 16, 17
       { 0, 0, 0, 1, 1, 2, 3, 5, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11 };
 
-BoggleSolver::BoggleSolver() : runs_(0), num_boards_(0) {}
-BoggleSolver::~BoggleSolver() {}
+BoggleSolver::BoggleSolver()
+    : runs_(0), iterative_(false), prefetch_(false),
+      num_boards_(0), num_dictionaries_(1), cache_utils_(NULL),
+      cache_hits_(0), cache_misses_(0) {}
+BoggleSolver::~BoggleSolver() { delete cache_utils_; }
 
-BoggleSolver* BoggleSolver::Create(int size, const char* dictionary_file) {
-  SimpleTrie* t = Boggler::DictionaryFromFile(dictionary_file);
+BoggleSolver* BoggleSolver::Create(int size, const char* dictionary_file,
+                                   bool use_dafsa) {
+  std::vector<std::string> files;
+  const char* start = dictionary_file;
+  for (const char* p = dictionary_file; ; p++) {
+    if (*p == ',' || *p == '\0') {
+      files.push_back(std::string(start, p - start));
+      if (!*p) break;
+      start = p + 1;
+    }
+  }
+  SimpleTrie* t = Boggler::DictionaryFromFiles(files);
   if (!t) return NULL;
 
   BoggleSolver* solver = NULL;
+  if (use_dafsa) {
+    if (size != 33 && size != 34 && size != 44) {
+      fprintf(stderr, "Unknown board size: %d\n", size);
+      delete t;
+      return NULL;
+    }
+    solver = new DafsaBoggler(new Dafsa(*t), size / 10, size % 10);
+    delete t;
+    solver->SetNumDictionaries(files.size());
+    return solver;
+  }
   switch (size) {
     case 33: solver = new Boggler3(t); break;
     case 34: solver = new Boggler34(t); break;
@@ -28,6 +55,7 @@ BoggleSolver* BoggleSolver::Create(int size, const char* dictionary_file) {
       fprintf(stderr, "Unknown board size: %d\n", size);
       return NULL;
   }
+  solver->SetNumDictionaries(files.size());
   return solver;
 }
 
@@ -53,6 +81,24 @@ BoggleSolver* BoggleSolver::Create(int size, const char* dictionary_file) {
   return true;
 }
 
+/* static */ void BoggleSolver::FindNeighbors(int w, int h,
+                                              int (*neighbors)[8], int* num) {
+  for (int x = 0; x < w; x++) {
+    for (int y = 0; y < h; y++) {
+      int i = x * h + y;
+      num[i] = 0;
+      for (int dx = -1; dx <= 1; dx++) {
+        if (x + dx < 0 || x + dx >= w) continue;
+        for (int dy = -1; dy <= 1; dy++) {
+          if (dx == 0 && dy == 0) continue;
+          if (y + dy < 0 || y + dy >= h) continue;
+          neighbors[i][num[i]++] = (x + dx) * h + y + dy;
+        }
+      }
+    }
+  }
+}
+
 bool BoggleSolver::ParseBoard(const char* bd) {
   unsigned int expected_len = Width() * Height();
   if (strlen(bd) != expected_len) {
@@ -84,13 +130,99 @@ bool BoggleSolver::ParseBoard(const char* bd) {
 // }
 
 int BoggleSolver::Score() {
-  // Really should check for overflow here
-  runs_ += 1;
+  CacheEntry* entry = NULL;
+  unsigned __int128 key;
+  if (!cache_.empty()) {
+    entry = CacheLookup(&key);
+    if (entry->key == key) {
+      cache_hits_ += 1;
+      num_boards_ += 1;
+      return entry->score;
+    }
+    cache_misses_ += 1;
+  }
+
+  NextRun();
   int score = InternalScore();
   num_boards_ += 1;
+
+  if (entry) {
+    entry->key = key;
+    entry->score = score;
+  }
   return score;
 }
 
+void BoggleSolver::SetScoreCacheSize(int num_entries) {
+  cache_.clear();
+  cache_hits_ = cache_misses_ = 0;
+  if (num_entries <= 0 || Width() * Height() > BoardUtils::kMaxCells) return;
+
+  int size = 1;
+  while (size < num_entries) size <<= 1;
+  CacheEntry empty = { 0, 0 };
+  cache_.resize(size, empty);
+
+  // BoardUtils numbers cells row by row, while we number them column by
+  // column. Swapping width and height makes the two agree.
+  if (!cache_utils_) cache_utils_ = new BoardUtils(Height(), Width());
+}
+
+BoggleSolver::CacheEntry* BoggleSolver::CacheLookup(unsigned __int128* key) {
+  char bd[BoardUtils::kMaxCells];
+  int w = Width();
+  int h = Height();
+  for (int x = 0; x < w; x++)
+    for (int y = 0; y < h; y++)
+      bd[x * h + y] = 'a' + Cell(x, y);
+  *key = cache_utils_->CanonicalPack(bd);
+
+  uint64_t hash = (uint64_t)*key * 0x9E3779B97F4A7C15ULL + (uint64_t)(*key >> 64);
+  hash ^= hash >> 29;
+  hash *= 0xBF58476D1CE4E5B9ULL;
+  hash ^= hash >> 32;
+  return &cache_[hash & (cache_.size() - 1)];
+}
+
+bool BoggleSolver::ScoreAtLeast(int threshold) {
+  if (threshold <= 0) return true;
+  if (!cache_.empty()) {
+    // A partial score can't go in the cache, but a full one can be used.
+    unsigned __int128 key;
+    CacheEntry* entry = CacheLookup(&key);
+    if (entry->key == key) {
+      cache_hits_ += 1;
+      num_boards_ += 1;
+      return entry->score >= threshold;
+    }
+    cache_misses_ += 1;
+  }
+  NextRun();
+  int score = InternalScoreAtLeast(threshold);
+  num_boards_ += 1;
+  return score >= threshold;
+}
+
+void BoggleSolver::ScoreDictionaries(int* scores) {
+  for (int d = 0; d < num_dictionaries_; d++) scores[d] = 0;
+  NextRun();
+  InternalScoreDictionaries(scores);
+  num_boards_ += 1;
+}
+
+bool BoggleSolver::ScoreDictionaries(const char* lets, int* scores) {
+  if (!ParseBoard(lets))
+    return false;
+  ScoreDictionaries(scores);
+  return true;
+}
+
+bool BoggleSolver::ScoreAtLeast(const char* lets, int threshold) {
+  if (!ParseBoard(lets))
+    return false;
+  return ScoreAtLeast(threshold);
+}
+
 std::string BoggleSolver::ToString() const {
   std::string out;
   int w = Width();
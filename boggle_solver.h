@@ -6,6 +6,30 @@
 
 #include <limits.h>
 #include <string>
+#include <vector>
+#include <sys/types.h>
+#include <stdint.h>
+
+class BoardUtils;
+
+// Receives the words found by BoggleSolver::FindWords(). Subclasses of the
+// solvers also have a templated FindWords() which takes any class with
+// FoundWord and VisitNode methods of this form, so that the calls can be
+// inlined.
+class WordVisitor {
+ public:
+  virtual ~WordVisitor() {}
+
+  // path holds the path_len cells used to spell the word, as indices into the
+  // board string. The path is only valid for the duration of the call.
+  virtual void FoundWord(int word_id, const int* path, int path_len,
+                         int points) = 0;
+
+  // Called with each Trie node the search enters, including the ones which
+  // don't lead to any words, e.g. to profile a dictionary (see TrieProfile).
+  // Only the Trie-based solvers call this.
+  virtual void VisitNode(const void* node) {}
+};
 
 // Interface for a boggle solver. Very specifically does not refer to the Trie
 // type, so that it does not need to be templated. Subclasses may be templated,
@@ -17,7 +41,11 @@ class BoggleSolver {
   
   // Construct a BoggleSolver for the given size board using the dictionary.
   // Possible sizes are: 33, 34, 44
-  static BoggleSolver* Create(int size, const char* dictionary_file);
+  // dictionary_file may be a comma-separated list of files, which are merged
+  // for use with ScoreDictionaries(). With use_dafsa, the solver is a
+  // DafsaBoggler, whose dictionary is a fraction of the size.
+  static BoggleSolver* Create(int size, const char* dictionary_file,
+                              bool use_dafsa = false);
 
   // Parses a board string like "abcdefghijklmnop"
   virtual bool ParseBoard(const char* lets);
@@ -29,6 +57,30 @@ class BoggleSolver {
   // Shortcut for ParseBoard() + Score()
   int Score(const char* lets);
 
+  // Does the current board score at least threshold points? This stops
+  // searching as soon as enough words have been found, so it's cheaper than
+  // Score() for boards which clear the bar. Boards which don't still require a
+  // full search.
+  bool ScoreAtLeast(int threshold);
+
+  // Shortcut for ParseBoard() + ScoreAtLeast(). Returns false on a bad board.
+  bool ScoreAtLeast(const char* lets, int threshold);
+
+  // The number of dictionaries merged into this solver's Trie (see Create).
+  // Score() counts the words in any of them.
+  int NumDictionaries() const { return num_dictionaries_; }
+  void SetNumDictionaries(int n) { num_dictionaries_ = n; }
+
+  // Scores the current board against each dictionary at once, setting
+  // scores[d] to its score using just dictionary d. This takes a single
+  // search, which is much cheaper than one per dictionary. Bypasses the
+  // score cache.
+  void ScoreDictionaries(int* scores);
+
+  // Shortcut for ParseBoard() + ScoreDictionaries(). Returns false on a bad
+  // board.
+  bool ScoreDictionaries(const char* lets, int* scores);
+
   virtual int Width() const = 0;
   virtual int Height() const = 0;
 
@@ -37,8 +89,36 @@ class BoggleSolver {
   virtual void SetCell(int x, int y, int c) = 0;
   virtual int Cell(int x, int y) const = 0;
 
+  // Reports each word on the current board once, in the order in which the
+  // search finds them. Doesn't allocate memory, except to build the table of
+  // words the first time it's called.
+  virtual void FindWords(WordVisitor* v) = 0;
+
+  // Maps a word id from FindWords() back to the word.
+  virtual const char* Word(int word_id) = 0;
+
+  // Use an explicit stack rather than recursion for the DFS in Score() and
+  // ScoreAtLeast(). Each solver defaults to whichever is faster for its board
+  // size; see perf_test.
+  void SetIterativeDFS(bool iterative) { iterative_ = iterative; }
+  bool IterativeDFS() const { return iterative_; }
+
+  // Before following any of a cell's neighbors, prefetch the Trie nodes for
+  // all of their letters. Each solver defaults to whichever is faster for its
+  // board size; see perf_test. Only affects the recursive DFS.
+  void SetPrefetchChildren(bool prefetch) { prefetch_ = prefetch; }
+  bool PrefetchChildren() const { return prefetch_; }
+
   // Returns the total number of boards that have evaluated.
-  int NumBoards() { return num_boards_; }
+  uint64_t NumBoards() { return num_boards_; }
+
+  // Remember the scores of recently-seen boards, keyed by their canonical
+  // rotation/reflection. Scoring a board whose symmetric image is in the cache
+  // skips the search entirely. The cache is direct-mapped with num_entries
+  // rounded up to a power of two. Pass 0 to disable it (the default).
+  void SetScoreCacheSize(int num_entries);
+  uint64_t CacheHits() const { return cache_hits_; }
+  uint64_t CacheMisses() const { return cache_misses_; }
 
   // Is this a valid boggle word? e.g. only has 'q' followed by 'u'.
   static bool IsBoggleWord(const char* word);
@@ -46,17 +126,281 @@ class BoggleSolver {
   // Returns true if it's a valid boggle word and converts "qu" -> 'q'
   static bool BogglifyWord(char* word);
 
+  // Points for a word of each length, with 'q' counted as two letters.
+  static const int kWordScores[];
+
+  // Fills in the neighbors of each cell of a w x h board, where cell (x, y)
+  // has index x * h + y. These can be used with NeighborLetterMasks().
+  static void FindNeighbors(int w, int h, int (*neighbors)[8], int* num);
+
  protected:
   virtual int InternalScore() = 0;
-  unsigned int runs_;  // TODO(danvk): This belongs to the Trie, not Boggler.
+
+  // Like InternalScore(), but may return early with any score >= threshold.
+  virtual int InternalScoreAtLeast(int threshold) = 0;
+
+  // Words are de-duped by marking their Trie nodes with runs_, which goes up
+  // by one for each board. If it ever wraps around, old marks could collide
+  // with new ones, so this is called to clear all the marks in the Trie.
+  virtual void ResetMarks() = 0;
+
+  // Sets scores[d] for each dictionary d, which have been zeroed. Call
+  // NextRun() first.
+  virtual void InternalScoreDictionaries(int* scores) = 0;
+
+  // Advances runs_, handling wraparound. Called before each search.
+  void NextRun() {
+    runs_ += 1;
+    if (runs_ == 0) {
+      ResetMarks();
+      runs_ = 1;
+    }
+  }
+
+  uintptr_t runs_;  // TODO(danvk): This belongs to the Trie, not Boggler.
+
+  // The DFS behind FindWords(), for a board with num_cells cells holding
+  // letters bd and neighbors as in FindNeighbors(). Words are marked in dict
+  // with runs_, so call NextRun() first.
+  template<class TrieT, class Visitor>
+  void FindWordsOnBoard(TrieT* dict, const int* bd, int num_cells,
+                        const int (*neighbors)[8], const int* num_neighbors,
+                        Visitor* v);
+
+  // The DFS behind ScoreDictionaries(), with arguments as in
+  // FindWordsOnBoard(). Each word is marked once, however many dictionaries
+  // it's in.
+  template<class TrieT>
+  void ScoreDictionariesOnBoard(TrieT* dict, const int* bd, int num_cells,
+                                const int (*neighbors)[8],
+                                const int* num_neighbors, int* scores);
+
+  // An iterative version of the solvers' DoDFS, for a board with num_cells
+  // cells holding letters bd and neighbors as in FindNeighbors(). If nbr_mask
+  // is non-NULL, it's used as in NeighborLetterMasks() to skip dead ends. With
+  // EarlyExit, the search stops once the score reaches threshold. Words are
+  // marked in dict with runs_, so call NextRun() first.
+  template<bool EarlyExit, class TrieT>
+  int IterativeSearch(TrieT* dict, const int* bd, int num_cells,
+                      const int (*neighbors)[8], const int* num_neighbors,
+                      const uint32_t* nbr_mask, int threshold);
+
+  bool iterative_;
+  bool prefetch_;
+
+  // Prefetches the children of t for the unused neighbors of cell i.
+  template<class TrieT>
+  static void PrefetchNeighbors(const TrieT* t, int i, uint32_t used,
+                                const int* bd, const int (*neighbors)[8],
+                                const int* num_neighbors) {
+    for (int j = 0; j < num_neighbors[i]; j++) {
+      int idx = neighbors[i][j];
+      if ((used & (1 << idx)) == 0) t->PrefetchChild(bd[idx]);
+    }
+  }
 
   static const int kCellUsed = -1;
-  static const int kWordScores[];
+
+  // Sets masks[i] to the letters on the neighbors of cell i (bit c for letter
+  // c). A DFS needn't look at the neighbors of a cell whose Trie node has no
+  // children in this mask.
+  static void NeighborLetterMasks(int num_cells, const int* bd,
+                                  const int (*neighbors)[8], const int* num,
+                                  uint32_t* masks) {
+    for (int i = 0; i < num_cells; i++) {
+      uint32_t mask = 0;
+      for (int j = 0; j < num[i]; j++) mask |= 1 << bd[neighbors[i][j]];
+      masks[i] = mask;
+    }
+  }
 
  private:
-  int num_boards_;
+  struct CacheEntry {
+    unsigned __int128 key;  // BoardUtils::PackedBoard; 0 means empty.
+    int score;
+  };
+
+  // Returns the cache slot for the current board and sets *key.
+  CacheEntry* CacheLookup(unsigned __int128* key);
+
+  uint64_t num_boards_;
+  int num_dictionaries_;
+
+  BoardUtils* cache_utils_;
+  std::vector<CacheEntry> cache_;
+  uint64_t cache_hits_;
+  uint64_t cache_misses_;
+
+  template<class TrieT, class Visitor> struct PathFinder;
+  template<class TrieT> struct DictionaryScorer;
+};
+
+template<class TrieT, class Visitor>
+struct BoggleSolver::PathFinder {
+  const int* bd;
+  const int (*neighbors)[8];
+  const int* num_neighbors;
+  uintptr_t mark;
+  Visitor* v;
+  uint32_t used;
+  int path[16];
+
+  void DoDFS(int i, int depth, int len, TrieT* t) {
+    const int kQ = 'q' - 'a';
+    path[depth] = i;
+    used ^= (1 << i);
+    len += (bd[i] == kQ ? 2 : 1);
+    v->VisitNode(t);
+    if (t->IsWord() && t->Mark() != mark) {
+      t->Mark(mark);
+      v->FoundWord(t->WordId(), path, depth + 1, kWordScores[len]);
+    }
+    for (int j = 0; j < num_neighbors[i]; j++) {
+      int idx = neighbors[i][j];
+      int cc = bd[idx];
+      if ((used & (1 << idx)) == 0 && t->StartsWord(cc))
+        DoDFS(idx, depth + 1, len, t->Descend(cc));
+    }
+    used ^= (1 << i);
+  }
+};
+
+template<class TrieT, class Visitor>
+void BoggleSolver::FindWordsOnBoard(TrieT* dict, const int* bd, int num_cells,
+                                    const int (*neighbors)[8],
+                                    const int* num_neighbors, Visitor* v) {
+  PathFinder<TrieT, Visitor> f;
+  f.bd = bd;
+  f.neighbors = neighbors;
+  f.num_neighbors = num_neighbors;
+  f.mark = runs_;
+  f.v = v;
+  f.used = 0;
+  for (int i = 0; i < num_cells; i++) {
+    int c = bd[i];
+    if (dict->StartsWord(c))
+      f.DoDFS(i, 0, 0, dict->Descend(c));
+  }
+}
+
+template<class TrieT>
+struct BoggleSolver::DictionaryScorer {
+  const int* bd;
+  const int (*neighbors)[8];
+  const int* num_neighbors;
+  uintptr_t mark;
+  int* scores;
+  uint32_t used;
+
+  void DoDFS(int i, int len, TrieT* t) {
+    const int kQ = 'q' - 'a';
+    used ^= (1 << i);
+    len += (bd[i] == kQ ? 2 : 1);
+    if (t->IsWord() && t->Mark() != mark) {
+      t->Mark(mark);
+      for (uint32_t d = t->Dictionaries(); d; d &= d - 1)
+        scores[__builtin_ctz(d)] += kWordScores[len];
+    }
+    for (int j = 0; j < num_neighbors[i]; j++) {
+      int idx = neighbors[i][j];
+      int cc = bd[idx];
+      if ((used & (1 << idx)) == 0 && t->StartsWord(cc))
+        DoDFS(idx, len, t->Descend(cc));
+    }
+    used ^= (1 << i);
+  }
 };
 
+template<class TrieT>
+void BoggleSolver::ScoreDictionariesOnBoard(TrieT* dict, const int* bd,
+                                            int num_cells,
+                                            const int (*neighbors)[8],
+                                            const int* num_neighbors,
+                                            int* scores) {
+  DictionaryScorer<TrieT> f;
+  f.bd = bd;
+  f.neighbors = neighbors;
+  f.num_neighbors = num_neighbors;
+  f.mark = runs_;
+  f.scores = scores;
+  f.used = 0;
+  for (int i = 0; i < num_cells; i++) {
+    int c = bd[i];
+    if (dict->StartsWord(c))
+      f.DoDFS(i, 0, dict->Descend(c));
+  }
+}
+
+template<bool EarlyExit, class TrieT>
+int BoggleSolver::IterativeSearch(TrieT* dict, const int* bd, int num_cells,
+                                  const int (*neighbors)[8],
+                                  const int* num_neighbors,
+                                  const uint32_t* nbr_mask, int threshold) {
+  const int kQ = 'q' - 'a';
+
+  // One frame per cell on the current path. next is the index of the next
+  // neighbor of cell i to try.
+  struct Frame {
+    TrieT* t;
+    int i;
+    int len;
+    int next;
+  } stack[16];
+
+  uint32_t used = 0;
+  int score = 0;
+  for (int start = 0; start < num_cells; start++) {
+    if (EarlyExit && score >= threshold) break;
+    int c = bd[start];
+    if (!dict->StartsWord(c)) continue;
+
+    // Entering a cell: mark it used, score the word and set up its frame.
+    int depth = 0;
+    int i = start;
+    TrieT* t = dict->Descend(c);
+    int len = (c == kQ ? 2 : 1);
+    for (;;) {
+      used ^= (1 << i);
+      if (t->IsWord() && t->Mark() != runs_) {
+        t->Mark(runs_);
+        score += kWordScores[len];
+      }
+      Frame* f = &stack[depth];
+      f->t = t;
+      f->i = i;
+      f->len = len;
+      f->next = (nbr_mask && (t->ChildMask() & nbr_mask[i]) == 0)
+                ? num_neighbors[i] : 0;
+
+      // Find the next cell to enter, popping frames which are out of
+      // neighbors.
+      for (;;) {
+        if (EarlyExit && score >= threshold) {
+          depth = -1;
+          break;
+        }
+        if (f->next == num_neighbors[f->i]) {
+          used ^= (1 << f->i);
+          if (--depth < 0) break;
+          f = &stack[depth];
+          continue;
+        }
+        int idx = neighbors[f->i][f->next++];
+        if (used & (1 << idx)) continue;
+        int cc = bd[idx];
+        if (!f->t->StartsWord(cc)) continue;
+        i = idx;
+        t = f->t->Descend(cc);
+        len = f->len + (cc == kQ ? 2 : 1);
+        depth += 1;
+        break;
+      }
+      if (depth < 0) break;
+    }
+  }
+  return score;
+}
+
 // Convenience specialization of GenericBoggler
 // Creates a SimpleTrie and then compacts it when loading from a dictionary.
 // class Boggler : public GenericBoggler<Trie> {
@@ -0,0 +1,107 @@
+// Author: danvk@google.com (Dan Vanderkam)
+
+#include "breaker_telemetry.h"
+
+#include <inttypes.h>
+#include <sys/time.h>
+#include <chrono>
+
+static double Now() {
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+BreakerTelemetry::BreakerTelemetry(const std::string& path, double interval)
+    : path_(path), interval_(interval), out_(NULL), start_time_(0.0),
+      last_flush_time_(0.0), last_reps_eliminated_(0),
+      total_work_(0), classes_(0), skipped_(0), nodes_(0), reps_total_(0),
+      reps_eliminated_(0),
+      sum_wins_(0), max_wins_(0), failures_(0), enumerated_(0),
+      bound_usecs_(0),
+      stopping_(false) {
+  for (int i = 0; i < kMaxDepth; i++) depth_counts_[i] = 0;
+}
+
+BreakerTelemetry::~BreakerTelemetry() {
+  Stop();
+}
+
+bool BreakerTelemetry::Start() {
+  out_ = fopen(path_.c_str(), "w");
+  if (!out_) {
+    fprintf(stderr, "Couldn't open stats file %s\n", path_.c_str());
+    return false;
+  }
+  start_time_ = last_flush_time_ = Now();
+  stopping_ = false;
+  flusher_ = std::thread(&BreakerTelemetry::FlushLoop, this);
+  return true;
+}
+
+void BreakerTelemetry::Stop() {
+  if (!out_) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  if (flusher_.joinable()) flusher_.join();
+  Flush();
+  fclose(out_);
+  out_ = NULL;
+}
+
+void BreakerTelemetry::FlushLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    wake_.wait_for(lock, std::chrono::duration<double>(interval_));
+    if (!stopping_) Flush();
+  }
+}
+
+void BreakerTelemetry::Flush() {
+  double now = Now();
+  double elapsed = now - start_time_;
+  uint64_t total = Get(reps_total_);
+  uint64_t elim = Get(reps_eliminated_);
+  uint64_t total_work = Get(total_work_);
+  uint64_t done = Get(classes_) + Get(skipped_);
+
+  double rate = elapsed > 0 ? elim / elapsed : 0.0;
+  double dt = now - last_flush_time_;
+  double recent_rate = dt > 0 ? (elim - last_reps_eliminated_) / dt : 0.0;
+  last_flush_time_ = now;
+  last_reps_eliminated_ = elim;
+
+  fprintf(out_, "{\"elapsed\": %.3f, \"classes\": %" PRIu64
+          ", \"skipped\": %" PRIu64,
+          elapsed, Get(classes_), Get(skipped_));
+  if (total_work) {
+    fprintf(out_, ", \"total_work\": %" PRIu64, total_work);
+    if (done) {
+      double eta = total_work > done
+                   ? (total_work - done) * elapsed / done : 0.0;
+      fprintf(out_, ", \"eta_secs\": %.1f", eta);
+    }
+  }
+  fprintf(out_, ", \"nodes\": %" PRIu64 ", \"eliminated\": %" PRIu64
+          ", \"reps_total\": %" PRIu64 ", \"reps_eliminated\": %" PRIu64
+          ", \"reps_per_sec\": %.1f, \"recent_reps_per_sec\": %.1f"
+          ", \"sum_wins\": %" PRIu64
+          ", \"max_wins\": %" PRIu64 ", \"failures\": %" PRIu64
+          ", \"enumerated\": %" PRIu64
+          ", \"upper_bound_secs\": %.3f, \"depth_counts\": [",
+          Get(nodes_), Get(sum_wins_) + Get(max_wins_), total, elim,
+          rate, recent_rate, Get(sum_wins_), Get(max_wins_),
+          Get(failures_), Get(enumerated_), Get(bound_usecs_) / 1.0e6);
+
+  // Trim trailing zeros from the depth histogram.
+  int max_depth = kMaxDepth;
+  while (max_depth > 0 && Get(depth_counts_[max_depth - 1]) == 0) max_depth--;
+  for (int i = 0; i < max_depth; i++) {
+    fprintf(out_, "%s%" PRIu64, i ? ", " : "", Get(depth_counts_[i]));
+  }
+  fprintf(out_, "]}\n");
+  fflush(out_);
+}
@@ -0,0 +1,115 @@
+// Author: danvk@google.com (Dan Vanderkam)
+//
+// Low-overhead progress reporting for the Breaker. The breaker bumps a few
+// atomic counters as it goes and a background thread writes a snapshot of them
+// to a JSON-lines file every N seconds. This is much cheaper than printing a
+// line for every node with --print_progress, so it's suitable for long runs.
+//
+// Each line of the stats file looks like:
+//   {"elapsed": 10.0, "nodes": 1234, "eliminated": 1200, ...}
+//
+// The ETA ("eta_secs") is only written once the caller has said how many
+// classes there are with SetTotalWork(), and at least one has been done.
+
+#ifndef BREAKER_TELEMETRY_H
+#define BREAKER_TELEMETRY_H
+
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <sys/types.h>
+#include <stdint.h>
+
+class BreakerTelemetry {
+ public:
+  // Snapshots are appended to the file at path every interval seconds.
+  BreakerTelemetry(const std::string& path, double interval);
+
+  // Writes a final snapshot and stops the flushing thread.
+  ~BreakerTelemetry();
+
+  // Opens the stats file and starts the flushing thread. Returns false if the
+  // file couldn't be opened.
+  bool Start();
+
+  // Stops the flushing thread after writing one last snapshot. Safe to call
+  // more than once.
+  void Stop();
+
+  // The number of classes this run will go through, e.g. the number of board
+  // ids for --break_all. Set this once, before breaking any of them. The ETA
+  // comes from the rate at which they're finished or skipped.
+  void SetTotalWork(uint64_t classes) { total_work_ = classes; }
+
+  // A class which the caller passed over without breaking it, e.g. because
+  // it's not canonical. It counts as done for the ETA.
+  void SkipClass() { Add(&skipped_, 1); }
+
+  // Called by the Breaker. These are all cheap.
+  void StartClass(uint64_t reps) { Add(&reps_total_, reps); }
+  void FinishClass() { Add(&classes_, 1); }
+  void RecordNode(int depth) {
+    Add(&nodes_, 1);
+    Add(&depth_counts_[depth < kMaxDepth ? depth : kMaxDepth - 1], 1);
+  }
+  void RecordElimination(uint64_t reps, bool max_win) {
+    Add(&reps_eliminated_, reps);
+    Add(max_win ? &max_wins_ : &sum_wins_, 1);
+  }
+  void RecordFailure() { Add(&failures_, 1); }
+  // A class was scored exactly, and reps of its boards didn't fail.
+  void RecordEnumeration(uint64_t reps) {
+    Add(&reps_eliminated_, reps);
+    Add(&enumerated_, 1);
+  }
+  void RecordBoundTime(double secs) {
+    Add(&bound_usecs_, static_cast<uint64_t>(secs * 1.0e6));
+  }
+
+  // Write the current state of the counters to the stats file.
+  void Flush();
+
+ private:
+  static const int kMaxDepth = 64;
+
+  static void Add(std::atomic<uint64_t>* counter, uint64_t v) {
+    counter->fetch_add(v, std::memory_order_relaxed);
+  }
+  static uint64_t Get(const std::atomic<uint64_t>& counter) {
+    return counter.load(std::memory_order_relaxed);
+  }
+
+  void FlushLoop();
+
+  std::string path_;
+  double interval_;
+  FILE* out_;
+  double start_time_;
+
+  // Used to compute the recent rate between two snapshots.
+  double last_flush_time_;
+  uint64_t last_reps_eliminated_;
+
+  std::atomic<uint64_t> total_work_;  // 0 if unknown.
+  std::atomic<uint64_t> classes_;
+  std::atomic<uint64_t> skipped_;
+  std::atomic<uint64_t> nodes_;
+  std::atomic<uint64_t> reps_total_;
+  std::atomic<uint64_t> reps_eliminated_;
+  std::atomic<uint64_t> sum_wins_;
+  std::atomic<uint64_t> max_wins_;
+  std::atomic<uint64_t> failures_;
+  std::atomic<uint64_t> enumerated_;
+  std::atomic<uint64_t> bound_usecs_;
+  std::atomic<uint64_t> depth_counts_[kMaxDepth];
+
+  std::thread flusher_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stopping_;
+};
+
+#endif
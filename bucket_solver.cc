@@ -33,7 +33,8 @@ const int BucketSolver::kWordScores[] =
 }
 
 BucketSolver::BucketSolver(SimpleTrie* t)
-    : dict_(t), runs_(0), build_tree_(false) {}
+    : dict_(t), runs_(0), build_tree_(false), bound_threads_(1),
+      bound_min_letters_(0) {}
 BucketSolver::~BucketSolver() {}
 
 bool BucketSolver::ParseBoard(const char* bd) {
@@ -92,6 +93,14 @@ uint64_t BucketSolver::NumReps() const {
   return reps;
 }
 
+void BucketSolver::LetterUses(int max_uses[26]) const {
+  for (int i = 0; i < 26; i++) max_uses[i] = 0;
+  int num_cells = Width() * Height();
+  for (int i = 0; i < num_cells; i++) {
+    for (const char* c = Cell(i); *c; c++) max_uses[*c - 'a'] += 1;
+  }
+}
+
 const char* BucketSolver::as_string() {
   char* c = board_rep_;
   int num_cells = Width() * Height();
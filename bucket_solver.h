@@ -41,6 +41,15 @@ class BucketSolver {
   const char* Cell(int x, int y) const { return Cell(Height() * x + y); }
   char* MutableCell(int x, int y) { return MutableCell(Height() * x + y); }
 
+  // Sets max_uses[i] to the number of cells which could hold letter i, i.e.
+  // the most times a word on any board in the class could use it.
+  void LetterUses(int max_uses[26]) const;
+
+  // The dictionary used for bounds. The Breaker swaps in smaller ones (see
+  // SimpleTrie::Restrict) as the classes shrink. Not owned.
+  SimpleTrie* Dictionary() const { return dict_; }
+  void SetDictionary(SimpleTrie* t) { dict_ = t; }
+
   // Returns the number of individual boards in the current board class. This
   // isn't guaranteed to fit in a uint64_t, but will for any class you care to
   // evaluate.
@@ -56,6 +65,17 @@ class BucketSolver {
   // Compute an upper bound without any of the costly statistics.
   int UpperBound(int bailout_score = INT_MAX);
 
+  // Split the start cells of each bound between num_threads threads, but
+  // only for classes with at least min_letters letters in all (see
+  // NumPossibilities), since starting the threads costs more than a small
+  // bound. Bailouts are approximate in this mode. Only BucketSolver4
+  // supports this; the other sizes always use one thread.
+  void SetBoundThreads(int num_threads, int min_letters = 0) {
+    bound_threads_ = num_threads;
+    bound_min_letters_ = min_letters;
+  }
+  int BoundThreads() const { return bound_threads_; }
+
   // We should really write a paper on the exact meaning of these...
   struct ScoreDetails {
     int max_nomark;  // select the maximizing letter at each juncture.
@@ -87,8 +107,11 @@ class BucketSolver {
 
   bool build_tree_;
 
+  int bound_threads_;
+  int bound_min_letters_;
+
  private:
-  char board_rep_[27*9];  // for as_string()
+  char board_rep_[27*16];  // for as_string(), big enough for 4x4.
 };
 
 #endif
@@ -0,0 +1,124 @@
+#include "dafsa.h"
+
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include "trie.h"
+
+namespace {
+
+// Merges equivalent nodes of a SimpleTrie. Two nodes are equivalent if they
+// have the same word-ness and their children are equivalent, so working up
+// from the leaves, each node can be identified by its bits and the states
+// of its children.
+struct Minimizer {
+  std::unordered_map<std::string, uint32_t> ids;  // signature -> state
+  std::vector<uint32_t> bits;  // state -> children and word-ness
+  std::vector<std::vector<uint32_t> > children;  // state -> child states
+  std::vector<uint32_t> counts;  // state -> number of words through it
+  std::vector<uint8_t> dictionaries;  // by word id
+  bool many_dictionaries;
+
+  Minimizer() : many_dictionaries(false) {}
+
+  // Returns the state for t. Words are visited in alphabetical order.
+  uint32_t Add(const SimpleTrie& t) {
+    uint32_t b = t.ChildMask() | (t.IsWord() ? (1 << 26) : 0);
+    if (t.IsWord()) {
+      dictionaries.push_back(t.Dictionaries());
+      if (t.Dictionaries() > 1) many_dictionaries = true;
+    }
+    std::vector<uint32_t> kids;
+    uint32_t count = t.IsWord() ? 1 : 0;
+    for (int i = 0; i < kNumLetters; i++) {
+      if (!t.StartsWord(i)) continue;
+      uint32_t kid = Add(*t.Descend(i));
+      kids.push_back(kid);
+      count += counts[kid];
+    }
+
+    std::string sig((const char*)&b, sizeof(b));
+    if (!kids.empty())
+      sig.append((const char*)&kids[0], kids.size() * sizeof(uint32_t));
+    std::unordered_map<std::string, uint32_t>::iterator it = ids.find(sig);
+    if (it != ids.end()) return it->second;
+
+    uint32_t state = bits.size();
+    ids[sig] = state;
+    bits.push_back(b);
+    children.push_back(kids);
+    counts.push_back(count);
+    return state;
+  }
+};
+
+}  // namespace
+
+Dafsa::Dafsa(const SimpleTrie& t) {
+  Minimizer m;
+  uint32_t root = m.Add(t);
+  num_nodes_ = m.bits.size();
+  num_words_ = m.counts[root];
+  if (m.many_dictionaries) dictionaries_.swap(m.dictionaries);
+
+  // Lay the nodes out in BFS order, so that the root is at offset 0 and the
+  // nodes near the top, which every search visits, are close together.
+  std::vector<uint32_t> offsets(num_nodes_, UINT32_MAX);
+  std::vector<uint32_t> order;
+  std::queue<uint32_t> todo;
+  uint32_t size = 0;
+  todo.push(root);
+  offsets[root] = 0;
+  while (!todo.empty()) {
+    uint32_t s = todo.front();
+    todo.pop();
+    order.push_back(s);
+    offsets[s] = size;
+    size += 1 + 2 * m.children[s].size();
+    for (int i = 0; i < m.children[s].size(); i++) {
+      uint32_t kid = m.children[s][i];
+      if (offsets[kid] != UINT32_MAX) continue;
+      offsets[kid] = 0;  // queued
+      todo.push(kid);
+    }
+  }
+
+  nodes_.resize(size);
+  for (int n = 0; n < order.size(); n++) {
+    uint32_t s = order[n];
+    uint32_t* p = &nodes_[offsets[s]];
+    *p++ = m.bits[s];
+    uint32_t skip = (m.bits[s] & (1 << 26)) ? 1 : 0;
+    for (int i = 0; i < m.children[s].size(); i++) {
+      uint32_t kid = m.children[s][i];
+      *p++ = offsets[kid];
+      *p++ = skip;
+      skip += m.counts[kid];
+    }
+  }
+}
+
+std::string Dafsa::Word(uint32_t id) const {
+  // The skips of a node's edges increase, so the word is down the last edge
+  // which skips no more than id words.
+  std::string out;
+  Node n = Root();
+  while (!IsWord(n) || id != 0) {
+    int next = -1;
+    uint32_t next_skip = 0;
+    for (int i = 0; i < kNumLetters; i++) {
+      if (!StartsWord(n, i)) continue;
+      uint32_t skip = 0;
+      Descend(n, i, &skip);
+      if (skip > id) break;
+      next = i;
+      next_skip = skip;
+    }
+    if (next == -1) return "";  // id is out of range.
+    out += (next == kQ ? std::string("qu") : std::string(1, 'a' + next));
+    uint32_t unused = 0;
+    n = Descend(n, next, &unused);
+    id -= next_skip;
+  }
+  return out;
+}
@@ -0,0 +1,70 @@
+// A minimized, acyclic automaton (DAFSA) for a dictionary. Unlike a Trie,
+// words which end the same way share their suffixes, so this is a small
+// fraction of the size of even the compact Trie.
+//
+// Because nodes are shared, a node can't stand for a single word, so it can't
+// hold a mark. Instead each node records how many words pass through it, and
+// each edge how many words come before the ones it leads to. Summing these
+// along a path gives each word a dense id (its position in alphabetical
+// order), which a solver can use to index a table of marks.
+//
+// The whole automaton lives in one array of uint32_t's. A node is its offset
+// in the array: a bits word as in Trie (children in bits 0-25, word-ness in
+// bit 26), followed by two entries for each child: its offset and the number
+// of words which are skipped by following it.
+
+#ifndef DAFSA_H__
+#define DAFSA_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+class SimpleTrie;
+
+class Dafsa {
+ public:
+  typedef uint32_t Node;
+
+  // Builds the minimal automaton for the words in t, e.g. a Trie from
+  // Boggler::DictionaryFromFiles. t is no longer needed afterwards.
+  explicit Dafsa(const SimpleTrie& t);
+
+  Node Root() const { return 0; }
+  bool IsWord(Node n) const { return nodes_[n] & (1 << 26); }
+  bool StartsWord(Node n, int i) const { return nodes_[n] & (1 << i); }
+
+  // Bit i is set if StartsWord(n, i).
+  uint32_t ChildMask(Node n) const { return nodes_[n] & ((1 << 26) - 1); }
+
+  // Follows letter i from n. StartsWord(n, i) must be true. Start *id at 0 at
+  // the root; at a word node, it's the id of the word.
+  Node Descend(Node n, int i, uint32_t* id) const {
+    const uint32_t* e = &nodes_[n + 1 + 2 * __builtin_popcount(
+                                    nodes_[n] & ((1 << i) - 1))];
+    *id += e[1];
+    return e[0];
+  }
+
+  int NumWords() const { return num_words_; }
+  int NumNodes() const { return num_nodes_; }
+  size_t MemoryUsage() const { return nodes_.size() * sizeof(uint32_t); }
+
+  // The word with the given id, with 'q' spelled out as "qu". Ids are as in
+  // WordTable. This walks the automaton, so it's not especially fast.
+  std::string Word(uint32_t id) const;
+
+  // The dictionaries word id is in, as in SimpleTrie::Dictionaries(). For a
+  // single dictionary, this is always 1.
+  uint32_t Dictionaries(uint32_t id) const {
+    return dictionaries_.empty() ? 1 : dictionaries_[id];
+  }
+
+ private:
+  std::vector<uint32_t> nodes_;
+  std::vector<uint8_t> dictionaries_;  // by word id; empty if there's one.
+  int num_words_;
+  int num_nodes_;
+};
+
+#endif
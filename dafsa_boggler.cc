@@ -0,0 +1,67 @@
+#include "dafsa_boggler.h"
+
+#include <assert.h>
+
+struct DafsaBoggler::Scorer {
+  int score;
+  bool Done() const { return false; }
+  void FoundWord(uint32_t id, const int* path, int path_len, int points) {
+    score += points;
+  }
+};
+
+struct DafsaBoggler::ThresholdScorer {
+  int score;
+  int threshold;
+  bool Done() const { return score >= threshold; }
+  void FoundWord(uint32_t id, const int* path, int path_len, int points) {
+    score += points;
+  }
+};
+
+struct DafsaBoggler::DictionaryScorer {
+  const Dafsa* dict;
+  int* scores;
+  bool Done() const { return false; }
+  void FoundWord(uint32_t id, const int* path, int path_len, int points) {
+    for (uint32_t d = dict->Dictionaries(id); d; d &= d - 1)
+      scores[__builtin_ctz(d)] += points;
+  }
+};
+
+DafsaBoggler::DafsaBoggler(Dafsa* d, int w, int h)
+    : dict_(d), marks_(d->NumWords(), 0), w_(w), h_(h), num_cells_(w * h) {
+  assert(num_cells_ <= 16);
+  FindNeighbors(w, h, neighbors_, num_neighbors_);
+  for (int i = 0; i < num_cells_; i++) bd_[i] = 0;
+}
+
+DafsaBoggler::~DafsaBoggler() {
+  delete dict_;
+}
+
+const char* DafsaBoggler::Word(int word_id) {
+  word_ = dict_->Word(word_id);
+  return word_.c_str();
+}
+
+int DafsaBoggler::InternalScore() {
+  Scorer f = { 0 };
+  Search(&f);
+  return f.score;
+}
+
+int DafsaBoggler::InternalScoreAtLeast(int threshold) {
+  ThresholdScorer f = { 0, threshold };
+  Search(&f);
+  return f.score;
+}
+
+void DafsaBoggler::ResetMarks() {
+  marks_.assign(marks_.size(), 0);
+}
+
+void DafsaBoggler::InternalScoreDictionaries(int* scores) {
+  DictionaryScorer f = { dict_, scores };
+  Search(&f);
+}
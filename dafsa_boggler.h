@@ -0,0 +1,120 @@
+// A solver for boards of any size up to 4x4 which uses a Dafsa rather than a
+// Trie for its dictionary. The Dafsa can't hold marks, so words are de-duped
+// with a table of marks indexed by word id instead.
+
+#ifndef DAFSA_BOGGLER_H
+#define DAFSA_BOGGLER_H
+
+#include <string>
+#include <vector>
+#include "boggle_solver.h"
+#include "dafsa.h"
+
+class DafsaBoggler : public BoggleSolver {
+ public:
+  // Assumes ownership of the Dafsa. Boards are w x h, with w * h <= 16.
+  DafsaBoggler(Dafsa* d, int w, int h);
+  virtual ~DafsaBoggler();
+
+  void SetCell(int x, int y, int c) { bd_[x * h_ + y] = c; }
+  int Cell(int x, int y) const { return bd_[x * h_ + y]; }
+
+  // Reports each word on the current board to v->FoundWord(); see
+  // WordVisitor in boggle_solver.h. Visitor needn't be a WordVisitor.
+  template<class Visitor> void FindWords(Visitor* v);
+  virtual void FindWords(WordVisitor* v) { FindWords<WordVisitor>(v); }
+  virtual const char* Word(int word_id);
+
+  int Width() const { return w_; }
+  int Height() const { return h_; }
+
+  const Dafsa& Dictionary() const { return *dict_; }
+
+ protected:
+  virtual int InternalScore();
+  virtual int InternalScoreAtLeast(int threshold);
+  virtual void ResetMarks();
+  virtual void InternalScoreDictionaries(int* scores);
+
+ private:
+  // Each search calls f->FoundWord(id, path, path_len, points) for the words
+  // it finds, and stops once f->Done().
+  template<class Found> void Search(Found* f);
+  template<class Found> void DoDFS(int i, int depth, int len, Dafsa::Node n,
+                                   uint32_t id, Found* f);
+
+  struct Scorer;
+  struct ThresholdScorer;
+  struct DictionaryScorer;
+  template<class Visitor> struct VisitorAdapter;
+
+  Dafsa* dict_;
+  std::vector<uintptr_t> marks_;  // by word id; == runs_ if already found.
+  std::string word_;  // storage for Word().
+  int w_, h_, num_cells_;
+  uint32_t used_;
+  int bd_[16];
+  int path_[16];
+  int neighbors_[16][8];
+  int num_neighbors_[16];
+  uint32_t nbr_mask_[16];  // letters on the neighbors of each cell.
+};
+
+template<class Visitor>
+struct DafsaBoggler::VisitorAdapter {
+  Visitor* v;
+  bool Done() const { return false; }
+  void FoundWord(uint32_t id, const int* path, int path_len, int points) {
+    v->FoundWord(id, path, path_len, points);
+  }
+};
+
+template<class Visitor>
+void DafsaBoggler::FindWords(Visitor* v) {
+  NextRun();
+  VisitorAdapter<Visitor> f = { v };
+  Search(&f);
+}
+
+template<class Found>
+void DafsaBoggler::Search(Found* f) {
+  used_ = 0;
+  NeighborLetterMasks(num_cells_, bd_, neighbors_, num_neighbors_, nbr_mask_);
+  const Dafsa::Node root = dict_->Root();
+  for (int i = 0; i < num_cells_ && !f->Done(); i++) {
+    int c = bd_[i];
+    if (!dict_->StartsWord(root, c)) continue;
+    uint32_t id = 0;
+    Dafsa::Node n = dict_->Descend(root, c, &id);
+    DoDFS(i, 0, 0, n, id, f);
+  }
+}
+
+template<class Found>
+void DafsaBoggler::DoDFS(int i, int depth, int len, Dafsa::Node n,
+                         uint32_t id, Found* f) {
+  const int kQ = 'q' - 'a';
+  if (f->Done()) return;
+  const int c = bd_[i];
+  path_[depth] = i;
+  used_ ^= (1 << i);
+  len += (c == kQ ? 2 : 1);
+  if (dict_->IsWord(n) && marks_[id] != runs_) {
+    marks_[id] = runs_;
+    f->FoundWord(id, path_, depth + 1, kWordScores[len]);
+  }
+  if (dict_->ChildMask(n) & nbr_mask_[i]) {
+    for (int j = 0; j < num_neighbors_[i]; j++) {
+      int idx = neighbors_[i][j];
+      int cc = bd_[idx];
+      if ((used_ & (1 << idx)) == 0 && dict_->StartsWord(n, cc)) {
+        uint32_t child_id = id;
+        Dafsa::Node child = dict_->Descend(n, cc, &child_id);
+        DoDFS(idx, depth + 1, len, child, child_id, f);
+      }
+    }
+  }
+  used_ ^= (1 << i);
+}
+
+#endif
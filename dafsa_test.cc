@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+#include "test.h"
+#include "boggle_solver.h"
+#include "dafsa.h"
+#include "dafsa_boggler.h"
+#include "4x4/boggler.h"
+#include "mtrandom/randomc.h"
+#include "trie.h"
+
+// Follows wd through d, returning the word id (or -1 if it's not a word).
+int Lookup(const Dafsa& d, const char* wd) {
+  Dafsa::Node n = d.Root();
+  uint32_t id = 0;
+  for (; *wd; wd++) {
+    int c = *wd - 'a';
+    if (!d.StartsWord(n, c)) return -1;
+    n = d.Descend(n, c, &id);
+  }
+  return d.IsWord(n) ? id : -1;
+}
+
+// Words which end the same way share nodes, and ids are alphabetical.
+void TestSmallDafsa() {
+  SimpleTrie t;
+  const char* kWords[] = { "tea", "teas", "sea", "seas", "pea", "peas", "pa" };
+  for (int i = 0; i < 7; i++) t.AddWord(kWords[i]);
+  Dafsa d(t);
+  CHECK_EQ(7, d.NumWords());
+  CHECK_EQ(14, TrieUtils<SimpleTrie>::NumNodes(&t));
+  // "ea(s)" is shared by three prefixes, and "pa" and "peas" end on the same
+  // node.
+  CHECK_EQ(6, d.NumNodes());
+
+  CHECK_EQ(0, Lookup(d, "pa"));
+  CHECK_EQ(1, Lookup(d, "pea"));
+  CHECK_EQ(2, Lookup(d, "peas"));
+  CHECK_EQ(3, Lookup(d, "sea"));
+  CHECK_EQ(4, Lookup(d, "seas"));
+  CHECK_EQ(5, Lookup(d, "tea"));
+  CHECK_EQ(6, Lookup(d, "teas"));
+  CHECK_EQ(-1, Lookup(d, "te"));
+  CHECK_EQ(-1, Lookup(d, "pas"));
+  for (int i = 0; i < 7; i++) CHECK_EQ(kWords[i], d.Word(Lookup(d, kWords[i])));
+  CHECK_EQ("", d.Word(7));
+}
+
+// Every word in a real dictionary gets the same id as in WordTable.
+void TestDictionary() {
+  SimpleTrie* t = Boggler::DictionaryFromFile("words");
+  WordTable words(t);
+  Dafsa d(*t);
+  CHECK_EQ(words.NumWords(), d.NumWords());
+  CHECK(d.NumNodes() < TrieUtils<SimpleTrie>::NumNodes(t) / 2);
+  for (int i = 0; i < words.NumWords(); i += 97)
+    CHECK_EQ(std::string(words.Word(i)), d.Word(i));
+  CHECK_EQ(1, d.Dictionaries(0));
+  delete t;
+}
+
+// Records the words found by FindWords().
+struct WordCollector : public WordVisitor {
+  void FoundWord(int word_id, const int* path, int path_len, int points) {
+    ids.push_back(word_id);
+  }
+  std::vector<int> ids;
+};
+
+// The process's resident size in MB, from /proc/self/statm.
+long ResidentMB() {
+  long size = 0, resident = 0;
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (!f) return 0;
+  if (fscanf(f, "%ld %ld", &size, &resident) != 2) resident = 0;
+  fclose(f);
+  return resident * sysconf(_SC_PAGESIZE) / (1 << 20);
+}
+
+// Create() frees the SimpleTrie once the Dafsa is built, so a DafsaBoggler
+// keeps only a few MB of the >100MB it took to load the dictionaries. This
+// has to run first, before other tests grow the heap.
+void TestDafsaMemory() {
+  long before = ResidentMB();
+  BoggleSolver* trie = BoggleSolver::Create(44, "words,twl.txt");
+  long with_trie = ResidentMB();
+  delete trie;
+  long after_trie = ResidentMB();
+  BoggleSolver* dafsa = BoggleSolver::Create(44, "words,twl.txt", true);
+  long with_dafsa = ResidentMB();
+  delete dafsa;
+
+  CHECK(with_trie - before > 50);
+  CHECK(after_trie - before < 20);
+  CHECK(with_dafsa - before < 20);
+}
+
+// A DafsaBoggler agrees with the Trie-based solvers.
+void TestSolvers() {
+  TRandomMersenne r(0xdaf5a);
+  const int kSizes[] = { 33, 34, 44 };
+  for (int s = 0; s < 3; s++) {
+    BoggleSolver* trie = BoggleSolver::Create(kSizes[s], "words,twl.txt");
+    BoggleSolver* dafsa = BoggleSolver::Create(kSizes[s], "words,twl.txt",
+                                               true);
+    CHECK_EQ(trie->Width(), dafsa->Width());
+    CHECK_EQ(trie->Height(), dafsa->Height());
+    CHECK_EQ(2, dafsa->NumDictionaries());
+    int n = trie->Width() * trie->Height();
+    for (int rep = 0; rep < 1000; rep++) {
+      char bd[17];
+      for (int i = 0; i < n; i++) bd[i] = 'a' + r.IRandom(0, 25);
+      bd[n] = '\0';
+      CHECK_EQ(trie->Score(bd), dafsa->Score(bd));
+      CHECK_EQ(trie->ScoreAtLeast(bd, 20), dafsa->ScoreAtLeast(bd, 20));
+
+      int trie_scores[2], dafsa_scores[2];
+      trie->ScoreDictionaries(bd, trie_scores);
+      dafsa->ScoreDictionaries(bd, dafsa_scores);
+      CHECK_EQ(trie_scores[0], dafsa_scores[0]);
+      CHECK_EQ(trie_scores[1], dafsa_scores[1]);
+
+      WordCollector trie_words, dafsa_words;
+      trie->FindWords(&trie_words);
+      dafsa->FindWords(&dafsa_words);
+      CHECK_EQ(trie_words.ids.size(), dafsa_words.ids.size());
+      for (int i = 0; i < dafsa_words.ids.size(); i++) {
+        CHECK_EQ(std::string(trie->Word(dafsa_words.ids[i])),
+                 std::string(dafsa->Word(dafsa_words.ids[i])));
+        CHECK_IN(dafsa_words.ids[i], trie_words.ids);
+      }
+    }
+    delete trie;
+    delete dafsa;
+  }
+}
+
+int main(int argc, char** argv) {
+  TestDafsaMemory();
+  TestSmallDafsa();
+  TestDictionary();
+  TestSolvers();
+  printf("%s: All tests passed!\n", argv[0]);
+}
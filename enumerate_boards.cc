@@ -0,0 +1,323 @@
+// Exhaustively score every board in a board class.
+//
+// This is a brute-force cross-check for ibucket_breaker: rather than bounding
+// the scores of the boards in a class, it scores each one of them. A class is
+// given in the breaker's format, e.g.
+//
+//   $ ./enumerate_boards --size 33 --best_score 500 "s t r e a e d lp lp"
+//
+// Boards are visited in reflected Gray code order, so that each board differs
+// from the one before it in a single cell. Cells are fixed one at a time, in
+// order, and fixing cell j only searches the paths whose highest cell is j:
+// those which start there, and the paths through cells 0..j-1 which were
+// recorded as stepping into it. The words and paths found for cells 0..j-1
+// are kept while cell j runs through its letters, so moving to the next board
+// usually only costs the paths through the last cell.
+//
+// The first --prefix_cells cells are the "prefix". Threads take prefixes one
+// at a time and enumerate the rest of the class under each of them.
+//
+// Boards which are rotations/reflections of a smaller board in the same class
+// are skipped with --filter_canonical.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "4x4/boggler.h"
+#include "board-utils.h"
+#include "boggle_solver.h"
+#include "gflags/gflags.h"
+#include "init.h"
+#include "trie.h"
+
+DEFINE_string(dictionary, "words", "Dictionary file");
+DEFINE_int32(size, 33, "Type of boggle board to use (MN = MxN)");
+DEFINE_int32(best_score, 0, "Report all boards scoring at least this much");
+DEFINE_int32(prefix_cells, 2, "Number of cells to split between threads");
+DEFINE_int32(threads, 0, "Number of threads (0 = one per core)");
+DEFINE_bool(filter_canonical, false,
+            "Skip boards whose canonical rotation/reflection is in the class");
+
+using std::string;
+using std::vector;
+
+double secs() {
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+// What one thread found.
+struct Results {
+  Results() : num_scored(0), num_skipped(0), max_score(-1) {}
+  uint64_t num_scored;
+  uint64_t num_skipped;
+  int max_score;
+  string max_board;
+  vector<std::pair<int, string> > good_boards;  // score >= --best_score
+};
+
+class Enumerator {
+ public:
+  static const int kMaxCells = 16;
+
+  // Cells are numbered as in BoggleSolver::ParseBoard.
+  Enumerator(int w, int h, const vector<string>& cells)
+      : dict_(Boggler::DictionaryFromFile(FLAGS_dictionary.c_str())),
+        bu_(h, w),  // BoardUtils numbers cells row by row.
+        cells_(cells), num_cells_(cells.size()), score_(0) {
+    TrieUtils<SimpleTrie>::SetAllMarks(dict_, 0);
+    BoggleSolver::FindNeighbors(w, h, neighbors_, num_neighbors_);
+    num_prefix_ = std::min(FLAGS_prefix_cells, num_cells_);
+    for (int i = 0; i < num_cells_; i++) {
+      letter_mask_[i] = 0;
+      for (int j = 0; j < cells_[i].size(); j++)
+        letter_mask_[i] |= 1 << (cells_[i][j] - 'a');
+      reversed_[i] = false;
+    }
+    bd_ = string(num_cells_, '.');
+  }
+  ~Enumerator() { delete dict_; }
+
+  // Number of distinct prefixes.
+  uint64_t NumPrefixes() const {
+    uint64_t n = 1;
+    for (int i = 0; i < num_prefix_; i++) n *= cells_[i].size();
+    return n;
+  }
+
+  // Takes prefixes from *next until they run out, and scores every board
+  // which starts with each of them.
+  void Run(std::atomic<uint64_t>* next, uint64_t num_prefixes, Results* out) {
+    for (uint64_t n; (n = (*next)++) < num_prefixes; ) {
+      for (int j = 0; j < num_prefix_; j++) {
+        int radix = cells_[j].size();
+        Fix(j, cells_[j][n % radix]);
+        n /= radix;
+      }
+      Enumerate(num_prefix_, out);
+      for (int j = num_prefix_ - 1; j >= 0; j--) Unfix(j);
+    }
+  }
+
+ private:
+  // A path through fixed cells which could step into a later cell. node is
+  // the Trie node for the path; used and len include all of its cells.
+  struct Path {
+    SimpleTrie* node;
+    uint32_t used;
+    int len;
+  };
+
+  // Runs cell j through its letters, forwards and backwards on alternate
+  // visits, and enumerates the later cells under each.
+  void Enumerate(int j, Results* out) {
+    if (j == num_cells_) {
+      Record(out);
+      return;
+    }
+    const string& letters = cells_[j];
+    for (int k = 0; k < letters.size(); k++) {
+      Fix(j, letters[reversed_[j] ? letters.size() - 1 - k : k]);
+      Enumerate(j + 1, out);
+      Unfix(j);
+    }
+    reversed_[j] = !reversed_[j];
+  }
+
+  void Record(Results* out) {
+    if (FLAGS_filter_canonical && !IsClassCanonical()) {
+      out->num_skipped += 1;
+      return;
+    }
+    out->num_scored += 1;
+    if (score_ > out->max_score) {
+      out->max_score = score_;
+      out->max_board = bd_;
+    }
+    if (score_ >= FLAGS_best_score) {
+      out->good_boards.push_back(std::make_pair(score_, bd_));
+    }
+  }
+
+  // Sets cell j, which must be the first unfixed cell, to c and finds the
+  // words on the paths whose highest cell is j.
+  void Fix(int j, char c) {
+    saved_score_[j] = score_;
+    for (int i = j + 1; i < num_cells_; i++)
+      saved_size_[j][i] = entering_[i].size();
+    bd_[j] = c;
+
+    int l = c - 'a';
+    if (dict_->StartsWord(l)) DoDFS(j, j, 0, 0, dict_->Descend(l));
+    // entering_[j] only grows while j is unfixed, so this is a fixed range.
+    const vector<Path>& paths = entering_[j];
+    for (int k = 0; k < paths.size(); k++) {
+      if (paths[k].node->StartsWord(l)) {
+        DoDFS(j, j, paths[k].used, paths[k].len, paths[k].node->Descend(l));
+      }
+    }
+  }
+
+  // Forgets everything Fix(j, ...) found.
+  void Unfix(int j) {
+    for (int k = 0; k < found_[j].size(); k++) found_[j][k]->Mark(0);
+    found_[j].clear();
+    for (int i = j + 1; i < num_cells_; i++)
+      entering_[i].resize(saved_size_[j][i]);
+    score_ = saved_score_[j];
+    bd_[j] = '.';
+  }
+
+  // Extends a path through cells 0..j into cell i, which t has already
+  // descended to. Paths which could step into a later cell are recorded for
+  // when it's fixed.
+  void DoDFS(int j, int i, uint32_t used, int len, SimpleTrie* t) {
+    used |= 1 << i;
+    len += (bd_[i] == 'q' ? 2 : 1);
+    if (t->IsWord() && !t->Mark()) {
+      t->Mark(1);
+      found_[j].push_back(t);
+      score_ += BoggleSolver::kWordScores[len];
+    }
+
+    for (int n = 0; n < num_neighbors_[i]; n++) {
+      int idx = neighbors_[i][n];
+      if (used & (1 << idx)) continue;
+      if (idx > j) {
+        if (t->ChildMask() & letter_mask_[idx]) {
+          Path p = { t, used, len };
+          entering_[idx].push_back(p);
+        }
+        continue;
+      }
+      int cc = bd_[idx] - 'a';
+      if (t->StartsWord(cc)) DoDFS(j, idx, used, len, t->Descend(cc));
+    }
+  }
+
+  // Is this the smallest of its rotations/reflections that's in the class?
+  bool IsClassCanonical() {
+    for (int s = 1; s < bu_.NumSymmetries(); s++) {
+      const int* perm = bu_.Symmetry(s);
+      bool in_class = true;
+      int cmp = 0;
+      for (int i = 0; i < num_cells_ && in_class; i++) {
+        char c = bd_[perm[i]];
+        in_class = letter_mask_[i] & (1 << (c - 'a'));
+        if (!cmp) cmp = c - bd_[i];
+      }
+      if (in_class && cmp < 0) return false;
+    }
+    return true;
+  }
+
+  SimpleTrie* dict_;
+  BoardUtils bu_;
+  vector<string> cells_;
+  int num_cells_;
+  int num_prefix_;
+  int num_neighbors_[kMaxCells];
+  int neighbors_[kMaxCells][8];
+  uint32_t letter_mask_[kMaxCells];  // letters in each cell of the class.
+  bool reversed_[kMaxCells];  // direction of each cell's Gray code digit.
+
+  string bd_;  // '.' for cells which aren't fixed yet.
+  int score_;
+  vector<Path> entering_[kMaxCells];  // paths which could step into a cell.
+  vector<SimpleTrie*> found_[kMaxCells];  // words found by Fix(j, ...).
+  int saved_score_[kMaxCells];
+  size_t saved_size_[kMaxCells][kMaxCells];
+};
+
+int main(int argc, char** argv) {
+  Init(&argc, &argv);
+
+  int w = FLAGS_size / 10, h = FLAGS_size % 10;
+  if (w * h > Enumerator::kMaxCells || w < 1 || h < 1) {
+    fprintf(stderr, "Unknown board size: %d\n", FLAGS_size);
+    exit(1);
+  }
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s [flags] 'ab cd ef ...'\n", argv[0]);
+    exit(1);
+  }
+
+  vector<string> cells;
+  std::istringstream iss(argv[1]);
+  string cell;
+  while (iss >> cell) {
+    std::sort(cell.begin(), cell.end());
+    for (int i = 0; i < cell.size(); i++) {
+      if (cell[i] < 'a' || cell[i] > 'z') {
+        fprintf(stderr, "Found unexpected letter: '%c'\n", cell[i]);
+        exit(1);
+      }
+    }
+    cells.push_back(cell);
+  }
+  if (cells.size() != w * h) {
+    fprintf(stderr, "Expected %d cells in the class, got %zu\n",
+            w * h, cells.size());
+    exit(1);
+  }
+  if (FLAGS_prefix_cells < 0 || FLAGS_prefix_cells > cells.size()) {
+    fprintf(stderr, "--prefix_cells must be between 0 and %zu\n",
+            cells.size());
+    exit(1);
+  }
+
+  int num_threads = FLAGS_threads;
+  if (num_threads <= 0) num_threads = std::thread::hardware_concurrency();
+  if (num_threads <= 0) num_threads = 1;
+
+  // Each thread needs its own Enumerator, since they mark words in the Trie.
+  vector<Enumerator*> enumerators;
+  for (int i = 0; i < num_threads; i++) {
+    enumerators.push_back(new Enumerator(w, h, cells));
+  }
+  uint64_t num_prefixes = enumerators[0]->NumPrefixes();
+
+  double start = secs();
+  std::atomic<uint64_t> next(0);
+  vector<Results> results(num_threads);
+  vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.push_back(std::thread(&Enumerator::Run, enumerators[i],
+                                  &next, num_prefixes, &results[i]));
+  }
+  for (int i = 0; i < num_threads; i++) threads[i].join();
+  double elapsed = secs() - start;
+
+  Results total;
+  for (int i = 0; i < num_threads; i++) {
+    const Results& r = results[i];
+    total.num_scored += r.num_scored;
+    total.num_skipped += r.num_skipped;
+    if (r.max_score > total.max_score) {
+      total.max_score = r.max_score;
+      total.max_board = r.max_board;
+    }
+    total.good_boards.insert(total.good_boards.end(),
+                             r.good_boards.begin(), r.good_boards.end());
+    delete enumerators[i];
+  }
+
+  std::sort(total.good_boards.begin(), total.good_boards.end());
+  for (int i = total.good_boards.size() - 1; i >= 0; i--) {
+    printf("%s: %d\n", total.good_boards[i].second.c_str(),
+           total.good_boards[i].first);
+  }
+  printf("Best board: %s (%d)\n", total.max_board.c_str(), total.max_score);
+  printf("Scored %llu boards (skipped %llu) in %.2fs = %.0f bds/sec\n",
+         (unsigned long long)total.num_scored,
+         (unsigned long long)total.num_skipped,
+         elapsed, total.num_scored / elapsed);
+}
@@ -0,0 +1,138 @@
+#include "family_scorer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "boggle_solver.h"
+
+FamilyScorer::FamilyScorer(TrieT* t, int width, int height)
+    : dict_(t), w_(width), h_(height), num_cells_(width * height),
+      free_mask_(0), num_paths_(0), runs_(0), base_mark_(0),
+      used_(0), score_(0), base_score_(0) {
+  TrieUtils<TrieT>::SetAllMarks(dict_, 0);
+  BoggleSolver::FindNeighbors(w_, h_, neighbors_, num_neighbors_);
+}
+
+FamilyScorer::~FamilyScorer() { delete dict_; }
+
+bool FamilyScorer::SetBase(const char* bd, const std::vector<int>& free_cells) {
+  if (strlen(bd) != num_cells_) {
+    fprintf(stderr, "Board strings must contain %d characters, got %zu ('%s')\n",
+            num_cells_, strlen(bd), bd);
+    return false;
+  }
+  for (int i = 0; i < num_cells_; i++) {
+    if (bd[i] < 'a' || bd[i] > 'z') {
+      fprintf(stderr, "Found unexpected letter: '%c'\n", bd[i]);
+      return false;
+    }
+    bd_[i] = bd[i] - 'a';
+  }
+
+  free_cells_ = free_cells;
+  free_mask_ = 0;
+  for (int k = 0; k < free_cells_.size(); k++) {
+    int cell = free_cells_[k];
+    if (cell < 0 || cell >= num_cells_ || (free_mask_ & (1 << cell))) {
+      fprintf(stderr, "Bad free cell: %d\n", cell);
+      return false;
+    }
+    free_mask_ |= 1 << cell;
+    free_index_[cell] = k;
+  }
+
+  paths_.clear();
+  paths_.resize(26 * free_cells_.size());
+  num_paths_ = 0;
+
+  runs_ += 1;
+  base_mark_ = runs_;
+  score_ = 0;
+  for (int i = 0; i < num_cells_; i++) {
+    if (free_mask_ & (1 << i)) continue;
+    int c = bd_[i];
+    used_ = 0;
+    if (dict_->StartsWord(c))
+      DoDFS<true>(i, 0, dict_->Descend(c));
+  }
+  base_score_ = score_;
+  return true;
+}
+
+int FamilyScorer::Score(const int* letters) {
+  const int num_free = free_cells_.size();
+  for (int k = 0; k < num_free; k++) bd_[free_cells_[k]] = letters[k];
+
+  runs_ += 1;
+  score_ = base_score_;
+  for (int k = 0; k < num_free; k++) {
+    int cell = free_cells_[k];
+    const std::vector<Path>& paths = paths_[k * 26 + letters[k]];
+    for (int j = 0; j < paths.size(); j++) {
+      used_ = paths[j].used;
+      DoDFS<false>(cell, paths[j].len, paths[j].node);
+    }
+  }
+
+  // Words which start in a free cell.
+  for (int k = 0; k < num_free; k++) {
+    int c = letters[k];
+    used_ = 0;
+    if (dict_->StartsWord(c))
+      DoDFS<false>(free_cells_[k], 0, dict_->Descend(c));
+  }
+  return score_;
+}
+
+void FamilyScorer::ScoreAll(std::vector<int>* scores) {
+  const int num_free = free_cells_.size();
+  int letters[kMaxCells] = { 0 };
+  int num_boards = 1;
+  for (int k = 0; k < num_free; k++) num_boards *= 26;
+
+  scores->resize(num_boards);
+  for (int n = 0; n < num_boards; n++) {
+    (*scores)[n] = Score(letters);
+    // Odometer-style increment, last free cell fastest.
+    for (int k = num_free - 1; k >= 0; k--) {
+      if (++letters[k] < 26) break;
+      letters[k] = 0;
+    }
+  }
+}
+
+template<bool Base>
+void FamilyScorer::DoDFS(int i, int len, TrieT* t) {
+  int c = bd_[i];
+
+  used_ ^= (1 << i);
+  len += (c==kQ ? 2 : 1);
+  if (t->IsWord()) {
+    uintptr_t mark = t->Mark();
+    if (mark != runs_ && (Base || mark != base_mark_)) {
+      t->Mark(runs_);
+      score_ += BoggleSolver::kWordScores[len];
+    }
+  }
+
+  for (int n = 0; n < num_neighbors_[i]; n++) {
+    int idx = neighbors_[i][n];
+    if (used_ & (1 << idx)) continue;
+    if (Base && (free_mask_ & (1 << idx))) {
+      // Bucket this path by the letter the free cell would need.
+      int k = free_index_[idx];
+      for (int cc = 0; cc < 26; cc++) {
+        if (t->StartsWord(cc)) {
+          Path p = { t->Descend(cc), used_, len };
+          paths_[k * 26 + cc].push_back(p);
+          num_paths_ += 1;
+        }
+      }
+      continue;
+    }
+    int cc = bd_[idx];
+    if (t->StartsWord(cc)) {
+      DoDFS<Base>(idx, len, t->Descend(cc));
+    }
+  }
+  used_ ^= (1 << i);
+}
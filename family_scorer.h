@@ -0,0 +1,104 @@
+// Score a family of boards which differ only in a few "free" cells.
+//
+// This is a generalization of multi/multiboggle, which did the same thing for
+// the two corner cells of a 4x4 board. The idea is that most of the work in
+// scoring a board is the DFS through cells which are the same for the whole
+// family. SetBase() does that part once:
+//
+//   1. Words which only use fixed cells are found and scored.
+//   2. Every path through fixed cells which could be continued into a free
+//      cell is recorded, bucketed by the free cell and the letter it would need
+//      to have.
+//
+// Scoring a filling of the free cells then only needs to continue the paths in
+// the buckets for the letters which were actually chosen, and to start new
+// paths from the free cells themselves.
+//
+// Typical usage:
+//   FamilyScorer fs(Boggler::DictionaryFromFile("words"), 4, 4);
+//   std::vector<int> free_cells;  // cell indices, as in ParseBoard()
+//   free_cells.push_back(5);
+//   free_cells.push_back(9);
+//   fs.SetBase("catdlinemaropets", free_cells);
+//   int lets[2] = { 'e' - 'a', 'r' - 'a' };
+//   int score = fs.Score(lets);
+
+#ifndef FAMILY_SCORER_H
+#define FAMILY_SCORER_H
+
+#include <vector>
+#include <sys/types.h>
+#include <stdint.h>
+#include "trie.h"
+
+class FamilyScorer {
+ public:
+  typedef SimpleTrie TrieT;
+
+  // Boards are width x height, with at most kMaxCells cells. Cells are
+  // numbered as in BoggleSolver::ParseBoard, i.e. i = x * height + y. Assumes
+  // ownership of the Trie, whose marks are used to de-dupe words.
+  FamilyScorer(TrieT* t, int width, int height);
+  ~FamilyScorer();
+
+  static const int kMaxCells = 16;
+
+  // Sets the board whose free_cells will be varied. The letters on the base
+  // board in those cells are ignored. Returns false on a bad board string.
+  bool SetBase(const char* bd, const std::vector<int>& free_cells);
+
+  // Scores the base board with the i-th free cell set to letters[i], where
+  // 0 <= letters[i] < 26.
+  int Score(const int* letters);
+
+  // Scores all 26^k fillings of the free cells. The first free cell varies
+  // most slowly, so the score for letters (l0, l1, ..., lk) goes in
+  // (*scores)[l0 * 26^(k-1) + l1 * 26^(k-2) + ... + lk].
+  void ScoreAll(std::vector<int>* scores);
+
+  // Points for words that only use fixed cells.
+  int BaseScore() const { return base_score_; }
+
+  // Number of partial paths which SetBase recorded.
+  size_t NumPaths() const { return num_paths_; }
+
+  int Width() const { return w_; }
+  int Height() const { return h_; }
+
+ private:
+  // A path through fixed cells which has just entered a free cell. node has
+  // already descended by the free cell's letter; used and len don't yet
+  // include the free cell.
+  struct Path {
+    TrieT* node;
+    uint32_t used;
+    int len;
+  };
+
+  // With Base, the DFS stays on fixed cells and records the paths which would
+  // step into a free cell. Otherwise it goes everywhere.
+  template<bool Base> void DoDFS(int i, int len, TrieT* t);
+
+  TrieT* dict_;
+  int w_, h_;
+  int num_cells_;
+  int num_neighbors_[kMaxCells];
+  int neighbors_[kMaxCells][8];
+
+  int bd_[kMaxCells];
+  uint32_t free_mask_;        // bit i is set if cell i is free.
+  std::vector<int> free_cells_;
+
+  // paths_[k * 26 + c] are the paths into the k-th free cell when it's c.
+  std::vector<std::vector<Path> > paths_;
+  int free_index_[kMaxCells];  // cell -> index into free_cells_.
+  size_t num_paths_;
+
+  uintptr_t runs_;
+  uintptr_t base_mark_;  // Mark on words that only use fixed cells.
+  uint32_t used_;
+  int score_;
+  int base_score_;
+};
+
+#endif
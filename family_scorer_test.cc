@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "test.h"
+#include "trie.h"
+#include "family_scorer.h"
+#include "boggle_solver.h"
+#include "3x3/boggler.h"
+#include "4x4/boggler.h"
+
+// Checks every filling of the free cells against a regular solver.
+void CheckFamily(FamilyScorer* fs, BoggleSolver* solver, const char* base,
+                 const std::vector<int>& free_cells) {
+  CHECK(fs->SetBase(base, free_cells));
+  std::vector<int> scores;
+  fs->ScoreAll(&scores);
+
+  std::string bd(base);
+  for (int n = 0; n < scores.size(); n++) {
+    for (int k = free_cells.size() - 1, m = n; k >= 0; k--, m /= 26) {
+      bd[free_cells[k]] = 'a' + m % 26;
+    }
+    if (solver->Score(bd.c_str()) != scores[n]) {
+      fprintf(stderr, "Mismatch on %s\n", bd.c_str());
+    }
+    CHECK_EQ(solver->Score(bd.c_str()), scores[n]);
+  }
+}
+
+void TestSmall() {
+  SimpleTrie* t = new SimpleTrie;
+  t->AddWord("ate");
+  t->AddWord("tea");
+  t->AddWord("eta");
+  t->AddWord("eat");
+  t->AddWord("teak");
+
+  FamilyScorer fs(t, 4, 4);
+  std::vector<int> free_cells;
+  free_cells.push_back(5);
+  CHECK(fs.SetBase("texxazxxyyyyzzzz", free_cells));
+  CHECK_EQ(4, fs.BaseScore());
+
+  int lets[1] = { 'k' - 'a' };
+  CHECK_EQ(5, fs.Score(lets));
+  lets[0] = 'x' - 'a';
+  CHECK_EQ(4, fs.Score(lets));
+
+  // With "a" free, most of the words go through it.
+  free_cells[0] = 4;
+  CHECK(fs.SetBase("texxzkxxyyyyzzzz", free_cells));
+  CHECK_EQ(0, fs.BaseScore());
+  lets[0] = 'a' - 'a';
+  CHECK_EQ(5, fs.Score(lets));
+  CHECK_EQ(5, fs.Score(lets));  // Scoring twice doesn't double count.
+
+  free_cells.push_back(4);
+  CHECK(!fs.SetBase("texxzkxxyyyyzzzz", free_cells));  // duplicate cell
+  CHECK(!fs.SetBase("texx", free_cells));
+}
+
+void TestAgainstBoggler(const char* dict_file) {
+  Boggler b(Boggler::DictionaryFromFile(dict_file));
+  FamilyScorer fs(Boggler::DictionaryFromFile(dict_file), 4, 4);
+
+  std::vector<int> cells;
+  cells.push_back(0);
+  cells.push_back(15);
+  CheckFamily(&fs, &b, "catdlinemaropets", cells);
+
+  cells.clear();
+  cells.push_back(6);
+  cells.push_back(9);
+  CheckFamily(&fs, &b, "perslatgsineters", cells);
+  CheckFamily(&fs, &b, "abcdefghijklmnop", cells);
+
+  cells.clear();
+  cells.push_back(2);
+  cells.push_back(5);
+  cells.push_back(10);
+  CHECK(fs.SetBase("streaeqdntoigsnp", cells));
+  int lets[3] = { 'u' - 'a', 'i' - 'a', 's' - 'a' };
+  CHECK_EQ(b.Score("stueaiqdntsigsnp"), fs.Score(lets));
+
+  Boggler3 b3(Boggler::DictionaryFromFile(dict_file));
+  FamilyScorer fs3(Boggler::DictionaryFromFile(dict_file), 3, 3);
+  cells.clear();
+  cells.push_back(4);
+  cells.push_back(8);
+  CheckFamily(&fs3, &b3, "streaedlp", cells);
+}
+
+int main(int argc, char** argv) {
+  TestSmall();
+  TestAgainstBoggler(argc == 2 ? argv[1] : "words");
+  printf("%s: All tests passed!\n", argv[0]);
+}
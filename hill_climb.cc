@@ -0,0 +1,79 @@
+// Use steepest-ascent hill climbing to find a good Boggle board.
+//
+// Starting from a random board, every board one letter change or cell swap
+// away is scored and the climber moves to the best of them. When none of
+// these is an improvement, it restarts from a new random board. Neighbors are
+// scored in parallel, so this benefits from --threads on a multi-core machine.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "mtrandom/randomc.h"
+#include "boggle_solver.h"
+#include "optimizer.h"
+#include "init.h"
+
+DEFINE_int32(max_restarts, 10, "Number of local optima to find before exiting");
+DEFINE_int32(target_score, 0, "Stop once a board scores this much (0 = never)");
+DEFINE_int32(threads, 0, "Number of threads (0 = one per core)");
+DEFINE_int32(rand_seed, -1, "Random seed (-1 means use time + pid)");
+
+DEFINE_bool(print_stats, false, "Print statistics after the run");
+
+DEFINE_string(dictionary, "words", "Path to dictionary of words");
+DEFINE_int32(size, 44, "Type of boggle board to use (MN = MxN)");
+
+typedef TRandomMersenne Random;
+
+int main(int argc, char** argv) {
+  Init(&argc, &argv);
+  if (FLAGS_rand_seed == -1) {
+    FLAGS_rand_seed = time(NULL) + getpid();
+  }
+  int num_threads = FLAGS_threads;
+  if (num_threads <= 0) num_threads = std::thread::hardware_concurrency();
+  if (num_threads <= 0) num_threads = 1;
+
+  LOG(INFO) << "Hill climbing parameters:";
+  LOG(INFO) << " max_restarts: " << FLAGS_max_restarts;
+  LOG(INFO) << " target_score: " << FLAGS_target_score;
+  LOG(INFO) << " threads: " << num_threads;
+  LOG(INFO) << " rand_seed: " << FLAGS_rand_seed;
+  LOG(INFO) << " dictionary: " << FLAGS_dictionary;
+
+  HillClimber::Options opts;
+  opts.max_restarts = FLAGS_max_restarts;
+  opts.target_score = FLAGS_target_score;
+
+  // Each solver marks words in its own Trie, so each thread needs its own.
+  std::vector<BoggleSolver*> solvers;
+  for (int i = 0; i < num_threads; i++) {
+    BoggleSolver* solver =
+      BoggleSolver::Create(FLAGS_size, FLAGS_dictionary.c_str());
+    if (!solver) {
+      fprintf(stderr, "Couldn't create solver: %d %s\n",
+              FLAGS_size, FLAGS_dictionary.c_str());
+      exit(1);
+    }
+    solvers.push_back(solver);
+  }
+
+  Random r(FLAGS_rand_seed);
+  BoggleMTRandom mt_wrap(&r);
+  HillClimber climber(solvers, opts, &mt_wrap);
+  climber.Run();
+  printf("%d\t%s\n", climber.FinalScore(), climber.FinalBoard());
+
+  if (FLAGS_print_stats) {
+    printf("      steps: %d\n", climber.FinalStats().steps);
+    printf("   restarts: %d\n", climber.FinalStats().restarts);
+    printf("evaluations: %d\n", climber.FinalStats().evaluations);
+  }
+
+  for (int i = 0; i < solvers.size(); i++) delete solvers[i];
+}
@@ -18,6 +18,8 @@ using namespace std;
 DEFINE_string(dictionary, "words", "Dictionary file");
 DEFINE_int32(size, 44, "Type of boggle board to use (MN = MxN)");
 DEFINE_bool(build_tree, false, "Build possibility trees?");
+DEFINE_int32(threads, 1, "Split the bound's start cells between this many "
+             "threads (4x4 only)");
 
 double secs() {
   struct timeval t;
@@ -38,8 +40,9 @@ int main(int argc, char** argv) {
     FLAGS_size, FLAGS_dictionary.c_str());
   CHECK(solver != NULL) << "Couldn't load dictionary";
   solver->SetBuildTree(FLAGS_build_tree);
+  solver->SetBoundThreads(FLAGS_threads);
 
-  char buf[400] = "";
+  char buf[27 * 16] = "";  // 26 letters and a space per cell.
   for (int i=1; i<argc; i++) {
     strcat(buf, argv[i]);
     if (i < argc-1) strcat(buf, " ");
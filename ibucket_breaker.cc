@@ -11,6 +11,7 @@
 #include <iostream>
 #include <iomanip>
 #include <math.h>
+#include <queue>
 #include <set>
 #include <string>
 #include <string.h>
@@ -19,6 +20,9 @@
 #include <vector>
 #include "gflags/gflags.h"
 #include "board-utils.h"
+#include "breaker_telemetry.h"
+#include "family_scorer.h"
+#include "trie.h"
 
 using std::cout;
 using std::endl;
@@ -43,6 +47,13 @@ Breaker::Breaker(BucketSolver* solver, int best_score)
   for (int i = 0; i < distance.size(); i++) {
     order_.push_back(distance[i].second);
   }
+
+  // BoardUtils numbers cells row by row, so transpose it to match the solver.
+  BoardUtils sym_bu(solver_->Height(), solver_->Width());
+  for (int s = 0; s < sym_bu.NumSymmetries(); s++) {
+    const int* perm = sym_bu.Symmetry(s);
+    syms_.push_back(std::vector<int>(perm, perm + cells_));
+  }
 }
 
 void Breaker::SetPickOrder(std::vector<int>& order) {
@@ -136,12 +147,15 @@ void Breaker::SplitBucket(int level) {
       if (*bd_class != ' ') bd.append(1, *bd_class);
     }
     details_->failures.push_back(bd);
+    if (options_.telemetry) options_.telemetry->RecordFailure();
     if (options_.print_progress) {
       cout << "Unable to break board: " << bd << endl;
     }
     return;
   }
 
+  if (options_.prune_symmetric && SplitSymmetric(cell, splits, level)) return;
+
   if (options_.print_progress) cout << "split cell " << cell << endl;
 
   strcpy(orig_bd, solver_->as_string());
@@ -162,6 +176,83 @@ void Breaker::SplitBucket(int level) {
   }
 }
 
+bool Breaker::SplitSymmetric(int cell, const std::vector<std::string>& splits,
+                             int level) {
+  // Find the symmetries which map the class onto itself.
+  std::vector<const std::vector<int>*> group;
+  for (int s = 0; s < syms_.size(); s++) {
+    const std::vector<int>& perm = syms_[s];
+    bool fixed = true;
+    for (int i = 0; fixed && i < cells_; i++) {
+      fixed = !strcmp(solver_->Cell(i), solver_->Cell(perm[i]));
+    }
+    if (fixed) group.push_back(&perm);
+  }
+
+  // Splitting a cell which every symmetry fixes keeps the children
+  // symmetric, so there's nothing to gain until a later split.
+  std::vector<int> orbit;
+  for (int s = 0; s < group.size(); s++) orbit.push_back((*group[s])[cell]);
+  std::sort(orbit.begin(), orbit.end());
+  orbit.erase(std::unique(orbit.begin(), orbit.end()), orbit.end());
+  if (orbit.size() == 1) return false;
+
+  // A child assigns a split to each cell in the orbit. Number these
+  // assignments in base n, with orbit[0] as the most significant digit.
+  const int n = splits.size();
+  const int m = orbit.size();
+  uint64_t num_children = 1;
+  for (int k = 0; k < m; k++) {
+    num_children *= n;
+    if (num_children > kMaxSymmetricChildren) return false;
+  }
+  std::vector<int> pos(cells_, -1);  // cell -> index in orbit
+  for (int k = 0; k < m; k++) pos[orbit[k]] = k;
+
+  if (options_.print_progress) {
+    cout << "split " << m << " symmetric cells around " << cell << endl;
+  }
+
+  std::string orig_bd = solver_->as_string();
+  std::vector<int> digits(m), image(m);
+  std::vector<uint64_t> images;
+  const uint64_t orig_weight = weight_;
+  for (uint64_t child = 0; child < num_children; child++) {
+    uint64_t c = child;
+    for (int k = m - 1; k >= 0; k--, c /= n) digits[k] = c % n;
+
+    // Under a symmetry, cell i of the image is cell perm[i] of the child.
+    // Only attack the child if it's the least of its images.
+    images.clear();
+    bool least = true;
+    for (int s = 0; least && s < group.size(); s++) {
+      const std::vector<int>& perm = *group[s];
+      uint64_t id = 0;
+      for (int k = 0; k < m; k++) id = id * n + digits[pos[perm[orbit[k]]]];
+      least = (id >= child);
+      images.push_back(id);
+    }
+    if (!least) continue;
+    std::sort(images.begin(), images.end());
+    uint64_t num_images =
+        std::unique(images.begin(), images.end()) - images.begin();
+
+    if (!solver_->ParseBoard(orig_bd.c_str())) {
+      fprintf(stderr, "bucket boggle couldn't parse '%s'\n", orig_bd.c_str());
+      exit(1);
+    }
+    for (int k = 0; k < m; k++) {
+      strcpy(solver_->MutableCell(orbit[k]), splits[digits[k]].c_str());
+    }
+    details_->num_symmetric += num_images - 1;
+    details_->symmetric_reps += (num_images - 1) * solver_->NumReps();
+    weight_ = orig_weight * num_images;
+    AttackBoard(level + 1, 1 + child, num_children);
+  }
+  weight_ = orig_weight;
+  return true;
+}
+
 // Shed/Split until finished
 void Breaker::AttackBoard(int level, int num, int outof) {
   uint64_t reps = solver_->NumReps();
@@ -178,20 +269,290 @@ void Breaker::AttackBoard(int level, int num, int outof) {
     details_->boards_considered.push_back(solver_->as_string());
   }
 
-  if (solver_->UpperBound(best_score_) <= best_score_) {
-    elim_ += solver_->NumReps();
-    if (solver_->Details().max_nomark <= solver_->Details().sum_union) {
-      details_->max_wins += 1;
-    } else {
-      details_->sum_wins += 1;
+  if (options_.telemetry) options_.telemetry->RecordNode(level);
+  int bound = UpperBound(best_score_);
+
+  if (bound <= best_score_) {
+    Eliminate(reps, level);
+    return;
+  }
+
+  if (options_.shed_letters) {
+    uint64_t elim_before = elim_;
+    if (ShedToConvergence(level)) {
+      if (level > details_->max_depth) details_->max_depth = level;
+      return;
+    }
+    if (elim_ != elim_before) {
+      // The class is smaller now, so its bound may have dropped.
+      reps = solver_->NumReps();
+      if (UpperBound(best_score_) <= best_score_) {
+        Eliminate(reps, level);
+        return;
+      }
     }
-    if (level > details_->max_depth) details_->max_depth = level;
+  }
+
+  // Rather than splitting a small class, which would take a bound for each
+  // of its sub-classes, score its boards.
+  if (reps > 0 && reps <= options_.enumerate_below) {
+    EnumerateClass(level);
     return;
+  }
+  if (options_.restrict_trie) {
+    SplitRestricted(level);
   } else {
     SplitBucket(level);
   }
 }
 
+int Breaker::UpperBound(int bailout_score) {
+  if (!options_.telemetry) return solver_->UpperBound(bailout_score);
+  double start = secs();
+  int bound = solver_->UpperBound(bailout_score);
+  options_.telemetry->RecordBoundTime(secs() - start);
+  return bound;
+}
+
+void Breaker::SplitRestricted(int level) {
+  // Most classes are eliminated by their first bound, so only restrict the
+  // dictionary for classes which are going to be split. Even so, a copy
+  // costs about as much as ten 4x4 bounds, so only make one once the class
+  // has lost a third of the letters the current dictionary was made for.
+  // Counting cells' letters instead would rarely trigger: classes are
+  // usually eliminated long before they have a third as many.
+  int max_uses[26];
+  solver_->LetterUses(max_uses);
+  int letters = 0;
+  for (int i = 0; i < 26; i++) letters += (max_uses[i] > 0);
+  if (3 * letters > 2 * dict_letters_) {
+    SplitBucket(level);
+    return;
+  }
+
+  // The class is a subset of the one the current dictionary was made for,
+  // so its words are a subset of that dictionary's.
+  SimpleTrie* parent = solver_->Dictionary();
+  int parent_letters = dict_letters_;
+  SimpleTrie* restricted = parent->Restrict(max_uses);
+  solver_->SetDictionary(restricted);
+  dict_letters_ = letters;
+  details_->num_restricted += 1;
+
+  SplitBucket(level);
+
+  solver_->SetDictionary(parent);
+  dict_letters_ = parent_letters;
+  delete restricted;
+}
+
+void Breaker::Eliminate(uint64_t reps, int level) {
+  reps *= weight_;
+  elim_ += reps;
+  bool max_win =
+      solver_->Details().max_nomark <= solver_->Details().sum_union;
+  if (max_win) {
+    details_->max_wins += 1;
+  } else {
+    details_->sum_wins += 1;
+  }
+  if (options_.telemetry) options_.telemetry->RecordElimination(reps, max_win);
+  if (level > details_->max_depth) details_->max_depth = level;
+}
+
+void Breaker::EnumerateClass(int level) {
+  std::vector<std::pair<int, std::string> > above;
+  uint64_t reps = ScoreClass(best_score_, &above);
+  for (int i = 0; i < above.size(); i++) {
+    const std::string& bd = above[i].second;
+    details_->failures.push_back(bd);
+    if (options_.telemetry) options_.telemetry->RecordFailure();
+    if (options_.print_progress) {
+      cout << "Unable to break board: " << bd << endl;
+    }
+  }
+
+  details_->num_enumerated += 1;
+  details_->enumerated_reps += reps;
+  elim_ += (reps - above.size()) * weight_;
+  if (options_.telemetry) {
+    options_.telemetry->RecordEnumeration((reps - above.size()) * weight_);
+  }
+  if (level > details_->max_depth) details_->max_depth = level;
+}
+
+uint64_t Breaker::ScoreClass(int threshold,
+                             std::vector<std::pair<int, std::string> >* above) {
+  // The last two cells with a choice of letters are varied by the
+  // FamilyScorer. The others are stepped through like an odometer.
+  std::vector<int> multi;
+  std::string bd(cells_, ' ');
+  for (int i = 0; i < cells_; i++) {
+    bd[i] = solver_->Cell(i)[0];
+    if (strlen(solver_->Cell(i)) > 1) multi.push_back(i);
+  }
+  int num_free = std::min<int>(2, multi.size());
+  std::vector<int> prefix(multi.begin(), multi.end() - num_free);
+  std::vector<int> free_cells(multi.end() - num_free, multi.end());
+
+  FamilyScorer* scorer = options_.scorer;
+  uint64_t reps = 0;
+  std::vector<int> pos(prefix.size(), 0);
+  for (;;) {
+    scorer->SetBase(bd.c_str(), free_cells);
+    int letters[2] = { 0, 0 };
+    int free_pos[2] = { 0, 0 };
+    for (;;) {
+      for (int k = 0; k < num_free; k++) {
+        char c = solver_->Cell(free_cells[k])[free_pos[k]];
+        letters[k] = c - 'a';
+        bd[free_cells[k]] = c;
+      }
+      reps += 1;
+      int score = scorer->Score(letters);
+      if (score > threshold) above->push_back(std::make_pair(score, bd));
+      int k = num_free - 1;
+      for (; k >= 0; k--) {
+        if (solver_->Cell(free_cells[k])[++free_pos[k]]) break;
+        free_pos[k] = 0;
+      }
+      if (k < 0) break;
+    }
+
+    int j = prefix.size() - 1;
+    for (; j >= 0; j--) {
+      const char* cell = solver_->Cell(prefix[j]);
+      if (cell[++pos[j]]) {
+        bd[prefix[j]] = cell[pos[j]];
+        break;
+      }
+      pos[j] = 0;
+      bd[prefix[j]] = cell[0];
+    }
+    if (j < 0) break;
+  }
+  return reps;
+}
+
+void Breaker::FindBest(FindBestDetails* details) {
+  // Classes are expanded in decreasing order of upper bound. Once the best
+  // bound left is no better than the best board found so far, that board is
+  // provably the best in the class.
+  typedef std::pair<int, std::string> Entry;  // (bound, class)
+  std::priority_queue<Entry> queue;
+
+  double start = secs();
+  details->board.clear();
+  details->score = best_score_;
+  details->num_bounds = 1;
+  details->num_expanded = 0;
+  details->num_pruned = 0;
+  details->num_enumerated = 0;
+  details->enumerated_reps = 0;
+  details->max_queue = 1;
+
+  std::string orig = solver_->as_string();
+  queue.push(Entry(UpperBound(), orig));
+  uint64_t leaf_reps = std::max<uint64_t>(1, options_.enumerate_below);
+  while (!queue.empty()) {
+    Entry top = queue.top();
+    queue.pop();
+    if (top.first <= details->score) {
+      details->num_pruned += queue.size() + 1;
+      break;
+    }
+    if (!solver_->ParseBoard(top.second.c_str())) {
+      fprintf(stderr, "bucket boggle couldn't parse '%s'\n",
+              top.second.c_str());
+      exit(1);
+    }
+    details->num_expanded += 1;
+    if (options_.print_progress) {
+      cout << top.first << " " << top.second << " (best so far: "
+           << details->score << ")" << endl;
+    }
+
+    uint64_t reps = solver_->NumReps();
+    if (reps == 0) continue;  // a class with a "." cell.
+    if (reps <= leaf_reps) {
+      std::vector<Entry> above;
+      details->num_enumerated += 1;
+      details->enumerated_reps += ScoreClass(details->score, &above);
+      for (int i = 0; i < above.size(); i++) {
+        if (above[i].first > details->score) {
+          details->score = above[i].first;
+          details->board = above[i].second;
+        }
+      }
+      continue;
+    }
+
+    std::vector<std::string> splits;
+    int cell = PickABucket(&splits, 0);
+    std::string cls = solver_->as_string();
+    for (int i = 0; i < splits.size(); i++) {
+      solver_->ParseBoard(cls.c_str());
+      strcpy(solver_->MutableCell(cell), splits[i].c_str());
+      // No bailout score here: a bound which stopped early would be too low
+      // to order the queue by.
+      int bound = UpperBound();
+      details->num_bounds += 1;
+      if (bound > details->score) {
+        queue.push(Entry(bound, solver_->as_string()));
+      } else {
+        details->num_pruned += 1;
+      }
+    }
+    if (queue.size() > details->max_queue) details->max_queue = queue.size();
+  }
+
+  solver_->ParseBoard(orig.c_str());
+  details->elapsed = secs() - start;
+}
+
+bool Breaker::ShedToConvergence(int level) {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int i = 0; i < cells_; i++) {
+      int cell = order_[i];
+      char orig_cell[27];
+      strcpy(orig_cell, solver_->Cell(cell));
+      int len = strlen(orig_cell);
+      if (len <= 1) continue;
+
+      std::string kept;
+      for (int j = 0; j < len; j++) {
+        char* forced = solver_->MutableCell(cell);
+        forced[0] = orig_cell[j];
+        forced[1] = '\0';
+        uint64_t reps = solver_->NumReps() * weight_;
+        if (UpperBound(best_score_) <= best_score_) {
+          elim_ += reps;
+          details_->num_sheds += 1;
+          details_->shed_reps += reps;
+          if (options_.telemetry) {
+            bool max_win =
+                solver_->Details().max_nomark <= solver_->Details().sum_union;
+            options_.telemetry->RecordElimination(reps, max_win);
+          }
+        } else {
+          kept += orig_cell[j];
+        }
+      }
+      strcpy(solver_->MutableCell(cell), kept.c_str());
+      if (kept.empty()) return true;
+      if (kept.size() < len) {
+        changed = true;
+        if (options_.print_progress) {
+          cout << std::string(level, ' ') << "shed cell " << cell << ": "
+               << orig_cell << " -> " << kept << endl;
+        }
+      }
+    }
+  }
+  return false;
+}
 
 void Breaker::Break(BreakDetails* details) {
   std::string orig = solver_->as_string();
@@ -202,12 +563,24 @@ void Breaker::Break(BreakDetails* details) {
   details_->failures.clear();
   details_->sum_wins = 0;
   details_->max_wins = 0;
+  details_->num_sheds = 0;
+  details_->shed_reps = 0;
+  details_->num_enumerated = 0;
+  details_->enumerated_reps = 0;
+  details_->num_symmetric = 0;
+  details_->symmetric_reps = 0;
+
+  details_->num_restricted = 0;
 
   elim_ = 0;
+  weight_ = 1;
+  dict_letters_ = 26;  // the full dictionary.
   orig_reps_ = solver_->NumReps();
+  if (options_.telemetry) options_.telemetry->StartClass(orig_reps_);
   details_->start_time = secs();
     AttackBoard();
   double b = secs();
+  if (options_.telemetry) options_.telemetry->FinishClass();
   double a = details_->start_time;
   if (options_.print_progress) {
     float pace = 1.0*elim_/(b-a);
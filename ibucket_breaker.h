@@ -8,16 +8,47 @@
 
 #include "bucket_solver.h"
 #include <string>
+#include <utility>
 #include <vector>
 
 class BreakDetails;
+struct FindBestDetails;
+class BreakerTelemetry;
+class FamilyScorer;
 
 // A class to collect various options for the Breaker.
 struct BreakOptions {
-  BreakOptions() : print_progress(false), record_progress(false) {}
+  BreakOptions()
+      : print_progress(false), record_progress(false), shed_letters(false),
+        enumerate_below(0), scorer(NULL), prune_symmetric(false),
+        restrict_trie(false), telemetry(NULL) {}
 
   bool print_progress;  // should breaking progress be printed to stdout?
   bool record_progress;  // should BreakDetails.boards_considered be filled?
+
+  // Before splitting a class, drop the letters which can be ruled out on
+  // their own. See Breaker::ShedToConvergence.
+  bool shed_letters;
+
+  // Classes of at most this many boards are scored exactly using scorer
+  // rather than bounded and split. Only boards which actually score more
+  // than best_score are then reported as failures.
+  uint64_t enumerate_below;
+  FamilyScorer* scorer;  // Not owned. Must be the same size as the solver.
+
+  // When a class is its own image under some rotations/reflections, split
+  // a whole orbit of cells at once and only attack one class from each
+  // orbit of children. See Breaker::SplitSymmetric. Failures are then only
+  // reported up to symmetry.
+  bool prune_symmetric;
+
+  // Bound each class with a copy of its parent's dictionary which only has
+  // the words that the class's letters could spell. See
+  // SimpleTrie::Restrict.
+  bool restrict_trie;
+
+  // If set, counters are updated here as the breaker goes. Not owned.
+  BreakerTelemetry* telemetry;
 };
 
 class Breaker {
@@ -29,6 +60,14 @@ class Breaker {
   // Attempt to break the board class.
   void Break(BreakDetails* details);
 
+  // Find the highest-scoring board in the class by best-first branch and
+  // bound, rather than breaking it against a fixed score. The threshold
+  // starts at best_score and rises as better boards are found, so pass a
+  // known lower bound (or 0). Classes are scored exactly once they have at
+  // most max(1, BreakOptions.enumerate_below) boards, so options.scorer must
+  // be set.
+  void FindBest(FindBestDetails* details);
+
   // board is a space-separated list of letters on each cell, e.g.
   // "ab cd ef gh ij kl mn op qr"
   bool ParseBoard(const std::string& board);
@@ -43,16 +82,59 @@ class Breaker {
  private:
   // TODO(danvk): document these
   int PickABucket(std::vector<std::string>* splits, int level);
+
+  // Removes each letter whose forced bound (the upper bound with its cell
+  // set to just that letter) is <= best_score_, repeating until no more
+  // letters can be removed, since each removal can lower the other bounds.
+  // Returns true if some cell lost all its letters, i.e. the whole class has
+  // been eliminated.
   bool ShedToConvergence(int level);
   void SplitBucket(int level);
+
+  // If the current class is symmetric and cell is moved by one of its
+  // symmetries, splits every cell in cell's orbit into splits, attacks one
+  // child from each orbit of children and returns true. Returns false
+  // (having done nothing) if there's no symmetry to exploit.
+  bool SplitSymmetric(int cell, const std::vector<std::string>& splits,
+                      int level);
+  static const uint64_t kMaxSymmetricChildren = 4096;
   void AttackBoard(int level = 0, int num=1, int outof=1);
 
+  // solver_->UpperBound(), with its time added to the telemetry's.
+  int UpperBound(int bailout_score = INT_MAX);
+
+  // SplitBucket, but with a dictionary restricted to the current class if
+  // it's shrunk enough. See BreakOptions.restrict_trie.
+  void SplitRestricted(int level);
+
+  // Records that the current class, with reps boards, has been eliminated.
+  void Eliminate(uint64_t reps, int level);
+
+  // Scores every board in the current class with options_.scorer, and
+  // records the ones which score more than best_score_ as failures.
+  void EnumerateClass(int level);
+
+  // Scores every board in the current class, adding (score, board) to above
+  // for each one which scores more than threshold. Returns the number of
+  // boards in the class.
+  uint64_t ScoreClass(int threshold,
+                      std::vector<std::pair<int, std::string> >* above);
+
   BucketSolver* solver_;
   BreakDetails* details_;
   int best_score_;
   uint64_t elim_;
   uint64_t orig_reps_;
 
+  // Each board in the current class stands for this many boards, counting
+  // the symmetric images which SplitSymmetric skipped.
+  uint64_t weight_;
+  std::vector<std::vector<int> > syms_;  // in the solver's cell numbering.
+
+  // The number of distinct letters in the class which the solver's
+  // dictionary was restricted to, or 26 for the full dictionary.
+  int dict_letters_;
+
   int cells_;
   std::vector<int> order_;
 
@@ -68,6 +150,23 @@ struct BreakDetails {
   int sum_wins;
   int max_wins;
 
+  // Letters removed by BreakOptions.shed_letters, and the boards they held.
+  int num_sheds;
+  uint64_t shed_reps;
+
+  // Classes scored exactly because of BreakOptions.enumerate_below, and the
+  // number of boards in them.
+  int num_enumerated;
+  uint64_t enumerated_reps;
+
+  // Child classes skipped by BreakOptions.prune_symmetric as images of
+  // other children, and the boards in them.
+  int num_symmetric;
+  uint64_t symmetric_reps;
+
+  // Dictionaries built for BreakOptions.restrict_trie.
+  int num_restricted;
+
   std::vector<std::string> failures;
 
   // only filled out if options.record_progress is set.
@@ -75,4 +174,18 @@ struct BreakDetails {
   std::vector<std::string> boards_considered;
 };
 
+struct FindBestDetails {
+  std::string board;  // empty if nothing beat the initial best_score.
+  int score;
+
+  // How much work the proof took.
+  uint64_t num_bounds;      // upper bounds computed.
+  uint64_t num_expanded;    // classes taken off the queue.
+  uint64_t num_pruned;      // classes dropped because of their bounds.
+  uint64_t num_enumerated;  // classes scored exactly...
+  uint64_t enumerated_reps;  // ...and the boards in them.
+  size_t max_queue;
+  double elapsed;
+};
+
 #endif
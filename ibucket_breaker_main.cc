@@ -14,6 +14,8 @@
 #include "4x4/ibuckets.h"
 #include "4x4/boggler.h"  // gross
 #include "board-utils.h"
+#include "breaker_telemetry.h"
+#include "family_scorer.h"
 #include "ibucket_breaker.h"
 #include "init.h"
 #include "gflags/gflags.h"
@@ -46,9 +48,48 @@ DEFINE_string(pick_cell_order, "",
               "Set to a comma-delimited permutation of cell indices to "
               "split them in that order, e.g. '0,1,2,3,4,5,6,7,8'");
 
+DEFINE_bool(shed_letters, false,
+            "Before splitting a class, drop letters whose forced upper bound "
+            "is already below --best_score.");
+
+DEFINE_int64(enumerate_below, 0,
+             "Score classes of at most this many boards exactly, rather than "
+             "bounding and splitting them. Only boards which really score "
+             "more than --best_score are reported.");
+
+DEFINE_bool(prune_symmetric, false,
+            "When a class is symmetric, only break one of each set of "
+            "symmetric sub-classes. Unbroken boards are reported up to "
+            "rotation/reflection.");
+
+DEFINE_bool(restrict_trie, false,
+            "Bound each class with just the words its letters could spell, "
+            "pruned from its parent's dictionary.");
+
+DEFINE_int32(bound_threads, 1,
+             "Split the start cells of each upper bound between this many "
+             "threads (4x4 only). Worth it for the first few, huge classes.");
+DEFINE_int32(bound_min_letters, 100,
+             "With --bound_threads, only use threads for classes with at "
+             "least this many letters in all.");
+
+DEFINE_bool(find_best, false,
+            "With --break_class, find the best board in the class by branch "
+            "and bound, using --best_score as the starting threshold.");
+
+DEFINE_string(stats_file, "",
+              "If set, write breaking statistics to this file as JSON lines.");
+DEFINE_double(stats_interval, 10.0,
+              "Seconds between lines written to --stats_file");
+
 
 using namespace std;
 void PrintDetails(BreakDetails& d);
+void PrintBest(const FindBestDetails& d);
+
+BreakerTelemetry* telemetry = NULL;
+void StopTelemetry() { if (telemetry) telemetry->Stop(); }
+
 uint64_t Rand64(uint64_t max, TRandomMersenne& rand);
 
 void SplitString(std::string& s, vector<int>* nums) {
@@ -79,11 +120,30 @@ int main(int argc, char** argv) {
     exit(1);
   }
 
+  solver->SetBoundThreads(FLAGS_bound_threads, FLAGS_bound_min_letters);
   Breaker breaker(solver, FLAGS_best_score);
   // BreakOptions opts;
   // opts.print_progress = FLAGS_display_debug_output;
   // breaker.SetOptions(opts);
 
+  BreakOptions opts;
+  opts.shed_letters = FLAGS_shed_letters;
+  opts.prune_symmetric = FLAGS_prune_symmetric;
+  opts.restrict_trie = FLAGS_restrict_trie;
+  if (FLAGS_enumerate_below > 0 || FLAGS_find_best) {
+    opts.enumerate_below = FLAGS_enumerate_below;
+    opts.scorer = new FamilyScorer(
+        Boggler::DictionaryFromFile(FLAGS_dictionary.c_str()),
+        solver->Width(), solver->Height());
+  }
+  if (!FLAGS_stats_file.empty()) {
+    telemetry = new BreakerTelemetry(FLAGS_stats_file, FLAGS_stats_interval);
+    if (!telemetry->Start()) exit(1);
+    atexit(StopTelemetry);  // the code below exits from several places.
+    opts.telemetry = telemetry;
+  }
+  breaker.SetOptions(opts);
+
   if (!FLAGS_pick_cell_order.empty()) {
     std::vector<int> picks;
     SplitString(FLAGS_pick_cell_order, &picks);
@@ -118,6 +178,7 @@ int main(int argc, char** argv) {
       exit(1);
     }
 
+    if (telemetry) telemetry->SetTotalWork(1);
     BreakDetails details;
     breaker.Break(&details);
     PrintDetails(details);
@@ -131,6 +192,13 @@ int main(int argc, char** argv) {
               FLAGS_break_class.c_str());
       exit(1);
     }
+    if (FLAGS_find_best) {
+      FindBestDetails best;
+      breaker.FindBest(&best);
+      PrintBest(best);
+      exit(0);
+    }
+    if (telemetry) telemetry->SetTotalWork(1);
     breaker.Break(&details);
     PrintDetails(details);
     exit(0);
@@ -145,6 +213,7 @@ int main(int argc, char** argv) {
     BreakDetails details;
     int num_cells = solver->Width() * solver->Height();
     uint64_t max_index = pow(classes.size(), num_cells);
+    if (telemetry) telemetry->SetTotalWork(FLAGS_random_boards);
     for (int i = 0; i < FLAGS_random_boards; i++) {
       uint64_t idx = Rand64(max_index - 1, r);
       string encoded_board = bu.BoardFromId(idx);
@@ -165,6 +234,7 @@ int main(int argc, char** argv) {
     int num_cells = solver->Width() * solver->Height();
     uint64_t max_index = pow(classes.size(), num_cells);
     vector<string> good_boards;
+    if (telemetry) telemetry->SetTotalWork(max_index);
     for (uint64_t idx = 0; idx < max_index; idx++) {
       if (idx % 100 == 0) {
         cout << idx << "/" << max_index << endl;
@@ -181,6 +251,8 @@ int main(int argc, char** argv) {
             good_boards.push_back(details.failures[i]);
           }
         }
+      } else if (telemetry) {
+        telemetry->SkipClass();
       }
     }
     for (int i = 0; i < good_boards.size(); i++) {
@@ -198,6 +270,22 @@ void PrintDetails(BreakDetails& d) {
          d.max_depth,
          d.elapsed, d.num_reps / d.elapsed,
          d.sum_wins, d.max_wins);
+  if (d.num_enumerated) {
+    printf("Enumerated %d classes with %llu boards\n", d.num_enumerated,
+           static_cast<unsigned long long int>(d.enumerated_reps));
+  }
+  if (d.num_sheds) {
+    printf("Shed %d letters, eliminating %llu boards\n", d.num_sheds,
+           static_cast<unsigned long long int>(d.shed_reps));
+  }
+  if (d.num_restricted) {
+    printf("Restricted the dictionary %d times\n", d.num_restricted);
+  }
+  if (d.num_symmetric) {
+    printf("Skipped %d symmetric classes with %llu boards\n",
+           d.num_symmetric,
+           static_cast<unsigned long long int>(d.symmetric_reps));
+  }
 
   if (!d.failures.empty()) {
     printf("Unbroken boards:\n");
@@ -207,6 +295,23 @@ void PrintDetails(BreakDetails& d) {
   }
 }
 
+void PrintBest(const FindBestDetails& d) {
+  if (d.board.empty()) {
+    printf("No board scores more than %d\n", d.score);
+  } else {
+    printf("Best board: %s (%d)\n", d.board.c_str(), d.score);
+  }
+  printf("Proved in %.4fs: %llu bounds, %llu classes expanded, "
+         "%llu pruned, %llu enumerated (%llu boards), max queue %zu\n",
+         d.elapsed,
+         static_cast<unsigned long long int>(d.num_bounds),
+         static_cast<unsigned long long int>(d.num_expanded),
+         static_cast<unsigned long long int>(d.num_pruned),
+         static_cast<unsigned long long int>(d.num_enumerated),
+         static_cast<unsigned long long int>(d.enumerated_reps),
+         d.max_queue);
+}
+
 uint64_t Rand64(uint64_t max, TRandomMersenne& rand) {
   if (max < (uint64_t)numeric_limits<int>::max()) {
     return rand.IRandom(0, max);
@@ -0,0 +1,360 @@
+// Find the highest-scoring boards within an edit distance of N of a seed.
+//
+// This does the same thing as
+//   neighbors -d N | sort -u | solve | sort -k2 -nr | head -K
+// but in a single process: boards are enumerated in memory, duplicates
+// (including rotations and reflections) are removed using their canonical
+// packed ids, and only the top K are kept.
+//
+// The work is split across threads by the first edit (a cell and its new
+// letter, or a swap): each thread takes the next first edit and enumerates
+// the boards that follow from it. The same board can be reached through
+// several first edits, so the threads share a set of the boards which have
+// been scored, split into shards with their own locks.
+//
+// The last substitution doesn't need a full solve for each of its 25 letters:
+// a FamilyScorer does the DFS through the rest of the board once, then scores
+// each letter in the changed cell. Other boards (the seed and swaps) get a full
+// solve. Each thread has two copies of the dictionary, one for each.
+//
+// The uniqued boards have to fit in memory: ~120k boards at d=2, but tens of
+// millions at d=3.
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "4x4/boggler.h"
+#include "board-utils.h"
+#include "boggle_solver.h"
+#include "family_scorer.h"
+#include "gflags/gflags.h"
+#include "init.h"
+
+DEFINE_string(dictionary, "words", "Dictionary file");
+DEFINE_int32(size, 44, "Type of boggle board to use (MN = MxN)");
+DEFINE_int32(d, 2, "Maximum edit distance from the seed board");
+DEFINE_int32(top_k, 10, "Number of boards to report for each seed");
+DEFINE_int32(threads, 0, "Number of threads (0 = one per core)");
+
+using std::string;
+using std::vector;
+
+typedef BoardUtils::PackedBoard Key;
+typedef std::pair<int, string> ScoredBoard;
+
+double secs() {
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+struct KeyHash {
+  size_t operator()(const Key& k) const {
+    uint64_t h = (uint64_t)k * 0x9E3779B97F4A7C15ULL + (uint64_t)(k >> 64);
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 32;
+    return h;
+  }
+};
+
+// The canonical ids of the boards which have been scored, shared between
+// threads.
+class SeenSet {
+ public:
+  // Returns true if key wasn't already in the set.
+  bool Insert(const Key& key) {
+    Shard& s = shards_[KeyHash()(key) % kNumShards];
+    std::lock_guard<std::mutex> lock(s.mu);
+    return s.keys.insert(key).second;
+  }
+
+  void Clear() {
+    for (int i = 0; i < kNumShards; i++) shards_[i].keys.clear();
+  }
+
+ private:
+  static const int kNumShards = 64;
+  struct Shard {
+    std::mutex mu;
+    std::unordered_set<Key, KeyHash> keys;
+  };
+  Shard shards_[kNumShards];
+};
+
+// The first step away from the seed: cell is set to let, or if let is 0,
+// swapped with cell2. At d=1, a substitution is a whole cell (let is '*'),
+// so that all of its letters can be scored together.
+struct Edit {
+  int cell;
+  int cell2;
+  char let;
+};
+
+// One seed's neighborhood, which the Workers split between them.
+struct Neighborhood {
+  string seed;
+  int d;
+  vector<Edit> edits;
+  std::atomic<size_t> next_edit;
+  SeenSet seen;
+
+  void Reset(const string& s, int dist) {
+    seed = s;
+    d = dist;
+    next_edit = 0;
+    seen.Clear();
+    edits.clear();
+    int n = seed.size();
+    for (int cell = 0; cell < n; cell++) {
+      if (d == 1) {
+        Edit e = { cell, -1, '*' };
+        edits.push_back(e);
+        continue;
+      }
+      for (char let = 'a'; let <= 'z'; let++) {
+        if (let == seed[cell]) continue;
+        Edit e = { cell, -1, let };
+        edits.push_back(e);
+      }
+    }
+    for (int cell1 = 0; cell1 < n; cell1++) {
+      for (int cell2 = cell1 + 1; cell2 < n; cell2++) {
+        if (seed[cell1] == seed[cell2]) continue;
+        Edit e = { cell1, cell2, 0 };
+        edits.push_back(e);
+      }
+    }
+  }
+};
+
+// Scores the boards which follow from the first edits it takes.
+class Worker {
+ public:
+  Worker(BoggleSolver* solver, FamilyScorer* fs)
+      : solver_(solver), fs_(fs), bu_(solver->Height(), solver->Width()),
+        num_scored_(0) {}
+
+  // Visits the seed itself if visit_seed is set.
+  void Search(Neighborhood* hood, bool visit_seed, int top_k) {
+    hood_ = hood;
+    top_ = std::priority_queue<ScoredBoard, vector<ScoredBoard>,
+                               std::greater<ScoredBoard> >();
+    top_k_ = top_k;
+    num_scored_ = 0;
+
+    char bd[BoardUtils::kMaxCells + 1];
+    strcpy(bd, hood->seed.c_str());
+    if (visit_seed) Visit(bd);
+    for (;;) {
+      size_t i = hood->next_edit++;
+      if (i >= hood->edits.size()) break;
+      FirstEdit(hood->edits[i], hood->d, bd);
+    }
+  }
+
+  // Pops the results, in increasing order of score.
+  void Results(vector<ScoredBoard>* out) {
+    while (!top_.empty()) {
+      out->push_back(top_.top());
+      top_.pop();
+    }
+  }
+
+  uint64_t NumScored() const { return num_scored_; }
+
+ private:
+  void Record(int score, const char* bd) {
+    num_scored_ += 1;
+    if (top_.size() < top_k_) {
+      top_.push(ScoredBoard(score, bd));
+    } else if (score > top_.top().first) {
+      top_.pop();
+      top_.push(ScoredBoard(score, bd));
+    }
+  }
+
+  void Visit(const char* bd) {
+    if (!hood_->seen.Insert(bu_.CanonicalPack(bd))) return;
+    Record(solver_->Score(bd), bd);
+  }
+
+  // Visits all the boards with a different letter in cell. The DFS through the
+  // other cells is shared between them.
+  void VisitCell(char* c, int cell) {
+    char orig = c[cell];
+    int lets[26];
+    int num_lets = 0;
+    for (char let = 'a'; let <= 'z'; let++) {
+      if (let == orig) continue;
+      c[cell] = let;
+      if (hood_->seen.Insert(bu_.CanonicalPack(c))) lets[num_lets++] = let;
+    }
+    if (num_lets) {
+      vector<int> free_cells(1, cell);
+      fs_->SetBase(c, free_cells);
+      for (int i = 0; i < num_lets; i++) {
+        c[cell] = lets[i];
+        int let = lets[i] - 'a';
+        Record(fs_->Score(&let), c);
+      }
+    }
+    c[cell] = orig;
+  }
+
+  // Visit all boards an edit distance of <= d - 1 from c after applying e.
+  // Leaves the board unaltered upon returning.
+  void FirstEdit(const Edit& e, int d, char* c) {
+    if (e.let == '*') {
+      VisitCell(c, e.cell);
+    } else if (e.let) {
+      char orig = c[e.cell];
+      c[e.cell] = e.let;
+      EditDistance(d - 1, c);
+      c[e.cell] = orig;
+    } else {
+      std::swap(c[e.cell], c[e.cell2]);
+      if (d == 1) Visit(c);
+      else        EditDistance(d - 1, c);
+      std::swap(c[e.cell], c[e.cell2]);
+    }
+  }
+
+  // Visit all boards an edit distance of <= d from c, as in neighbors.cc.
+  // Leaves the board unaltered upon returning.
+  void EditDistance(int d, char* c) {
+    int n = strlen(c);
+    for (int cell = 0; cell < n; cell++) {
+      if (d == 1) {
+        VisitCell(c, cell);
+        continue;
+      }
+      int orig = c[cell];
+      for (char let = 'a'; let <= 'z'; let++) {
+        if (let == orig) continue;
+        c[cell] = let;
+        EditDistance(d - 1, c);
+      }
+      c[cell] = orig;
+    }
+
+    for (int cell1 = 0; cell1 < n; cell1++) {
+      char orig = c[cell1];
+      for (int cell2 = cell1 + 1; cell2 < n; cell2++) {
+        if (orig == c[cell2]) continue;
+        char orig2 = c[cell2];
+        c[cell2] = orig;
+        c[cell1] = orig2;
+        if (d == 1) Visit(c);
+        else        EditDistance(d - 1, c);
+        c[cell2] = orig2;
+      }
+      c[cell1] = orig;
+    }
+  }
+
+  BoggleSolver* solver_;
+  FamilyScorer* fs_;
+  BoardUtils bu_;
+  Neighborhood* hood_;
+  int top_k_;
+  uint64_t num_scored_;
+  std::priority_queue<ScoredBoard, vector<ScoredBoard>,
+                      std::greater<ScoredBoard> > top_;
+};
+
+void SearchSeed(const string& seed, vector<Worker*>& workers,
+                Neighborhood* hood) {
+  double start = secs();
+  hood->Reset(seed, FLAGS_d);
+  vector<std::thread> threads;
+  for (int i = 0; i < workers.size(); i++) {
+    threads.push_back(std::thread(&Worker::Search, workers[i], hood, i == 0,
+                                  FLAGS_top_k));
+  }
+  vector<ScoredBoard> results;
+  uint64_t num_scored = 0;
+  for (int i = 0; i < workers.size(); i++) {
+    threads[i].join();
+    workers[i]->Results(&results);
+    num_scored += workers[i]->NumScored();
+  }
+  double elapsed = secs() - start;
+
+  std::sort(results.begin(), results.end(), std::greater<ScoredBoard>());
+  if (results.size() > FLAGS_top_k) results.resize(FLAGS_top_k);
+  for (int i = 0; i < results.size(); i++) {
+    printf("%s: %d\n", results[i].second.c_str(), results[i].first);
+  }
+  fprintf(stderr, "%s: %llu unique boards in %.2fs = %.2f boards/s\n",
+          seed.c_str(), (unsigned long long)num_scored, elapsed,
+          num_scored / elapsed);
+}
+
+int main(int argc, char** argv) {
+  Init(&argc, &argv);
+
+  int num_threads = FLAGS_threads;
+  if (num_threads <= 0) num_threads = std::thread::hardware_concurrency();
+  if (num_threads <= 0) num_threads = 1;
+
+  if (FLAGS_d < 1) {
+    fprintf(stderr, "--d must be at least 1\n");
+    exit(1);
+  }
+
+  // Each solver and FamilyScorer marks words in its own dictionary, so each
+  // thread needs its own.
+  vector<BoggleSolver*> solvers;
+  vector<FamilyScorer*> scorers;
+  vector<Worker*> workers;
+  for (int i = 0; i < num_threads; i++) {
+    BoggleSolver* solver =
+      BoggleSolver::Create(FLAGS_size, FLAGS_dictionary.c_str());
+    SimpleTrie* t = Boggler::DictionaryFromFile(FLAGS_dictionary.c_str());
+    if (!solver || !t) {
+      fprintf(stderr, "Couldn't create solver: %d %s\n",
+              FLAGS_size, FLAGS_dictionary.c_str());
+      exit(1);
+    }
+    solvers.push_back(solver);
+    scorers.push_back(
+        new FamilyScorer(t, solver->Width(), solver->Height()));
+    workers.push_back(new Worker(solver, scorers[i]));
+  }
+  const unsigned int num_cells = solvers[0]->Width() * solvers[0]->Height();
+
+  vector<string> seeds;
+  for (int i = 1; i < argc; i++) seeds.push_back(argv[i]);
+  if (argc == 1) {
+    string s;
+    while (std::cin >> s) seeds.push_back(s);
+  }
+
+  Neighborhood hood;
+  for (int i = 0; i < seeds.size(); i++) {
+    if (seeds[i].size() != num_cells ||
+        !solvers[0]->ParseBoard(seeds[i].c_str())) {
+      fprintf(stderr, "Couldn't parse board string '%s'\n", seeds[i].c_str());
+      continue;
+    }
+    SearchSeed(seeds[i], workers, &hood);
+  }
+
+  for (int i = 0; i < num_threads; i++) {
+    delete workers[i];
+    delete scorers[i];
+    delete solvers[i];
+  }
+}
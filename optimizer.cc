@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <iomanip>
+#include <thread>
 #include "boggle_solver.h"
 #include "glog/logging.h"
 #include "mtrandom/randomc.h"
@@ -136,3 +137,176 @@ bool Annealer::AcceptTransition(int cur_score, int new_score, double T) {
 double Annealer::Temperature(int n) {
   return opts_.cool_t0 * exp(-opts_.cool_k * n);
 }
+
+
+/* static */ HillClimber::Options HillClimber::DefaultOptions() {
+  Options ret;
+  ret.max_restarts = 10;
+  ret.target_score = 0;
+  return ret;
+}
+
+HillClimber::HillClimber(const std::vector<BoggleSolver*>& solvers,
+                         const Options& opts, BoggleRNG* rng)
+    : solvers_(solvers), rng_(rng), opts_(opts), best_score_(0),
+      batch_(NULL), batch_num_(0), pending_(0), stop_(false),
+      idxs_(solvers.size()), scores_(solvers.size()) {
+  CHECK(!solvers_.empty());
+  num_squares_ = solvers_[0]->Width() * solvers_[0]->Height();
+}
+
+HillClimber::~HillClimber() {}
+
+const char* HillClimber::FinalBoard() const {
+  return best_.c_str();
+}
+
+int HillClimber::FinalScore() const {
+  return best_score_;
+}
+
+const HillClimber::Stats& HillClimber::FinalStats() const {
+  return stats_;
+}
+
+void HillClimber::Run() {
+  stats_.steps = stats_.restarts = stats_.evaluations = 0;
+  best_score_ = 0;
+  best_.clear();
+
+  StartWorkers();
+  std::string bd;
+  std::vector<std::string> neighbors;
+  while (stats_.restarts < opts_.max_restarts) {
+    InitialBoard(&bd);
+    int score = solvers_[0]->Score(bd.c_str());
+    stats_.evaluations += 1;
+    VLOG(1) << "start board: " << bd << " (" << score << ")";
+
+    while (true) {
+      Neighbors(bd, &neighbors);
+      int new_score;
+      int idx = BestBoard(neighbors, &new_score);
+      if (new_score <= score) break;
+      bd = neighbors[idx];
+      score = new_score;
+      stats_.steps += 1;
+      VLOG(2) << stats_.steps << "\t" << bd << "\t" << score;
+    }
+
+    stats_.restarts += 1;
+    VLOG(1) << "local optimum: " << bd << " (" << score << ")";
+    if (score > best_score_) {
+      best_score_ = score;
+      best_ = bd;
+    }
+    if (opts_.target_score && best_score_ >= opts_.target_score) break;
+  }
+  StopWorkers();
+}
+
+void HillClimber::InitialBoard(std::string* bd) {
+  bd->resize(num_squares_);
+  for (int i = 0; i < num_squares_; i++) {
+    (*bd)[i] = rng_->IRandom('a', 'z');
+  }
+}
+
+void HillClimber::Neighbors(const std::string& bd,
+                            std::vector<std::string>* out) {
+  out->clear();
+  std::string n = bd;
+  for (int cell = 0; cell < num_squares_; cell++) {
+    for (char let = 'a'; let <= 'z'; let++) {
+      if (let == bd[cell]) continue;
+      n[cell] = let;
+      out->push_back(n);
+    }
+    n[cell] = bd[cell];
+  }
+
+  for (int a = 0; a < num_squares_; a++) {
+    for (int b = a + 1; b < num_squares_; b++) {
+      if (bd[a] == bd[b]) continue;
+      std::swap(n[a], n[b]);
+      out->push_back(n);
+      std::swap(n[a], n[b]);
+    }
+  }
+}
+
+void HillClimber::StartWorkers() {
+  stop_ = false;
+  for (int i = 0; i < solvers_.size() - 1; i++) {
+    workers_.push_back(std::thread(&HillClimber::WorkerLoop, this, i,
+                                   batch_num_));
+  }
+}
+
+void HillClimber::StopWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (int i = 0; i < workers_.size(); i++) workers_[i].join();
+  workers_.clear();
+}
+
+void HillClimber::WorkerLoop(int i, int last) {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (!stop_ && batch_num_ == last) start_.wait(lock);
+      if (stop_) return;
+      last = batch_num_;
+    }
+    ScoreShare(i);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_ -= 1;
+    }
+    done_.notify_one();
+  }
+}
+
+// Scores share i of the batch with solvers_[i], recording the best.
+void HillClimber::ScoreShare(int i) {
+  const std::vector<std::string>& bds = *batch_;
+  int n = solvers_.size();
+  int begin = bds.size() * i / n;
+  int end = bds.size() * (i + 1) / n;
+  idxs_[i] = -1;
+  scores_[i] = -1;
+  for (int j = begin; j < end; j++) {
+    int score = solvers_[i]->Score(bds[j].c_str());
+    if (score > scores_[i]) {
+      scores_[i] = score;
+      idxs_[i] = j;
+    }
+  }
+}
+
+int HillClimber::BestBoard(const std::vector<std::string>& bds, int* score) {
+  int n = solvers_.size();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch_ = &bds;
+    batch_num_ += 1;
+    pending_ = workers_.size();
+  }
+  start_.notify_all();
+  ScoreShare(n - 1);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (pending_ > 0) done_.wait(lock);
+  }
+  stats_.evaluations += bds.size();
+
+  int best = 0;
+  for (int i = 1; i < n; i++) {
+    if (scores_[i] > scores_[best]) best = i;
+  }
+  *score = scores_[best];
+  return idxs_[best];
+}
@@ -4,6 +4,11 @@
 #ifndef OPTIMIZER_H
 #define OPTIMIZER_H
 
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 #include "boggle_solver.h"
 class TRandomMersenne;
 
@@ -88,4 +93,77 @@ class Annealer {
   int num_squares_;
 };
 
+
+// Steepest-ascent hill climbing. At each step, every board one edit away (a
+// letter change or a swap of two cells) is scored and the climber moves to the
+// best of them. When no neighbor is an improvement, it restarts from a random
+// board. Neighbors are scored in parallel, one thread per solver. The threads
+// are started once per Run() and given each step's neighbors in turn.
+class HillClimber {
+ public:
+  struct Options {
+    int max_restarts;  // give up after this many local optima.
+    int target_score;  // stop as soon as a board scores this much (0 = never).
+  };
+
+  static Options DefaultOptions();
+
+  // There should be one solver per thread, all for the same board size.
+  // Doesn't take ownership of the solvers or the RNG.
+  HillClimber(const std::vector<BoggleSolver*>& solvers, const Options& opts,
+              BoggleRNG* rng);
+  ~HillClimber();
+
+  void Run();
+
+  // The best board found over all restarts.
+  const char* FinalBoard() const;
+  int FinalScore() const;
+
+  struct Stats {
+    int steps;        // moves to a better neighbor
+    int restarts;     // local optima reached
+    int evaluations;  // boards scored
+  };
+
+  const Stats& FinalStats() const;
+
+ private:
+  // A random initial board.
+  void InitialBoard(std::string* bd);
+
+  // All boards one letter change or swap away from bd.
+  void Neighbors(const std::string& bd, std::vector<std::string>* out);
+
+  // Returns the index of the best-scoring board, and sets *score.
+  int BestBoard(const std::vector<std::string>& bds, int* score);
+
+  // Worker i scores its share of each batch after batch number last with
+  // solvers_[i]. The calling thread scores the last share itself.
+  void StartWorkers();
+  void StopWorkers();
+  void WorkerLoop(int i, int last);
+  void ScoreShare(int i);
+
+  std::vector<BoggleSolver*> solvers_;
+  BoggleRNG* rng_;
+  Options opts_;
+  Stats stats_;
+  std::string best_;
+  int best_score_;
+  int num_squares_;
+
+  // The current batch, and each share's best board and score.
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  const std::vector<std::string>* batch_;
+  int batch_num_;  // incremented for each batch.
+  int pending_;    // workers which haven't finished the batch.
+  bool stop_;      // tells the workers to exit.
+  std::vector<int> idxs_;
+  std::vector<int> scores_;
+};
+
 #endif
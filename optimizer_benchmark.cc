@@ -0,0 +1,195 @@
+// Compare the Annealer and the HillClimber by how long each takes to find a
+// board scoring at least --target points.
+//
+// Each optimizer is run repeatedly (annealing runs or hill climbs from a
+// random board) until one of its boards hits the target or --time_limit
+// seconds have passed. This is repeated --trials times with different seeds.
+//
+// The Annealer is single-threaded, so for a fair comparison the HillClimber
+// also gets one thread. With --threads > 1 (the default on a multi-core
+// machine), it's run again with all of them, and reported separately. Each
+// run also reports the CPU time it used and the boards it scored per
+// CPU-second.
+//
+//   $ ./optimizer_benchmark --target 3500 --trials 2
+//   anneal   trial 0: 3593 spegelaneritsdes after 19.8s (80 runs, 19.5 CPU s, 14239 bds/CPU s)
+//   climb    trial 0: 3568 perslatgcineders after 7.8s (26 runs, 7.7 CPU s, 30472 bds/CPU s)
+//   anneal   trial 1: 3520 sticenalgreptsid after 2.8s (11 runs, 2.8 CPU s, 15075 bds/CPU s)
+//   climb    trial 1: 3500 splseiaertnrsedg after 0.5s (2 runs, 0.5 CPU s, 29605 bds/CPU s)
+//   anneal   reached 3500 in 2/2 trials, mean time 11.3s (11.1 CPU s)
+//   climb    reached 3500 in 2/2 trials, mean time 4.2s (4.1 CPU s)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gflags/gflags.h"
+#include "mtrandom/randomc.h"
+#include "boggle_solver.h"
+#include "optimizer.h"
+#include "init.h"
+
+DEFINE_int32(target, 3500, "Score to reach");
+DEFINE_double(time_limit, 600, "Give up on a trial after this many seconds");
+DEFINE_int32(trials, 1, "Number of trials for each optimizer");
+DEFINE_int32(threads, 0,
+             "Threads for the second hill climber run (0 = one per core)");
+DEFINE_int32(rand_seed, 1, "Random seed for the first trial");
+
+DEFINE_string(dictionary, "words", "Path to dictionary of words");
+DEFINE_int32(size, 44, "Type of boggle board to use (MN = MxN)");
+
+typedef TRandomMersenne Random;
+
+double secs() {
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+// CPU time used by all threads of this process.
+double cpu_secs() {
+  struct timespec t;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+  return t.tv_sec + t.tv_nsec / 1000000000.0;
+}
+
+uint64_t NumBoards(const std::vector<BoggleSolver*>& solvers) {
+  uint64_t n = 0;
+  for (int i = 0; i < solvers.size(); i++) n += solvers[i]->NumBoards();
+  return n;
+}
+
+struct Result {
+  Result(const std::vector<BoggleSolver*>& s)
+      : success(false), elapsed(0.0), cpu(0.0), boards(0), runs(0),
+        best_score(0), solvers(s), start(secs()), cpu_start(cpu_secs()),
+        boards_start(NumBoards(s)) {}
+
+  bool success;
+  double elapsed;
+  double cpu;
+  uint64_t boards;
+  int runs;
+  int best_score;
+  std::string best_board;
+
+  std::vector<BoggleSolver*> solvers;
+  double start, cpu_start;
+  uint64_t boards_start;
+};
+
+void Report(const char* name, int trial, const Result& r) {
+  printf("%-8s trial %d: %d %s %s %.1fs (%d runs, %.1f CPU s, "
+         "%.0f bds/CPU s)\n",
+         name, trial, r.best_score, r.best_board.c_str(),
+         r.success ? "after" : "FAILED, gave up after", r.elapsed, r.runs,
+         r.cpu, r.boards / r.cpu);
+  fflush(stdout);
+}
+
+// Update r with the outcome of one run. Returns true if it's time to stop.
+bool Record(Result* r, int score, const char* board) {
+  r->runs += 1;
+  if (score > r->best_score) {
+    r->best_score = score;
+    r->best_board = board;
+  }
+  r->elapsed = secs() - r->start;
+  r->cpu = cpu_secs() - r->cpu_start;
+  r->boards = NumBoards(r->solvers) - r->boards_start;
+  r->success = r->best_score >= FLAGS_target;
+  return r->success || r->elapsed > FLAGS_time_limit;
+}
+
+Result RunAnnealer(BoggleSolver* solver, int seed) {
+  Random rand(seed);
+  BoggleMTRandom rng(&rand);
+  Annealer annealer(solver, Annealer::DefaultOptions(), &rng);
+
+  Result r(std::vector<BoggleSolver*>(1, solver));
+  do {
+    annealer.Run();
+  } while (!Record(&r, annealer.FinalScore(), annealer.FinalBoard()));
+  return r;
+}
+
+Result RunClimber(const std::vector<BoggleSolver*>& solvers, int seed) {
+  Random rand(seed);
+  BoggleMTRandom rng(&rand);
+  HillClimber::Options opts = HillClimber::DefaultOptions();
+  opts.max_restarts = 1;  // one climb per run, so we can check the clock.
+  HillClimber climber(solvers, opts, &rng);
+
+  Result r(solvers);
+  do {
+    climber.Run();
+  } while (!Record(&r, climber.FinalScore(), climber.FinalBoard()));
+  return r;
+}
+
+void Summarize(const char* name, const std::vector<Result>& results) {
+  int successes = 0;
+  double total = 0.0, total_cpu = 0.0;
+  for (int i = 0; i < results.size(); i++) {
+    if (!results[i].success) continue;
+    successes += 1;
+    total += results[i].elapsed;
+    total_cpu += results[i].cpu;
+  }
+  printf("%-8s reached %d in %d/%d trials", name, FLAGS_target,
+         successes, (int)results.size());
+  if (successes) {
+    printf(", mean time %.1fs (%.1f CPU s)", total / successes,
+           total_cpu / successes);
+  }
+  printf("\n");
+}
+
+int main(int argc, char** argv) {
+  Init(&argc, &argv);
+  int num_threads = FLAGS_threads;
+  if (num_threads <= 0) num_threads = std::thread::hardware_concurrency();
+  if (num_threads <= 0) num_threads = 1;
+
+  std::vector<BoggleSolver*> solvers;
+  for (int i = 0; i < num_threads; i++) {
+    BoggleSolver* solver =
+      BoggleSolver::Create(FLAGS_size, FLAGS_dictionary.c_str());
+    if (!solver) {
+      fprintf(stderr, "Couldn't create solver: %d %s\n",
+              FLAGS_size, FLAGS_dictionary.c_str());
+      exit(1);
+    }
+    solvers.push_back(solver);
+  }
+
+  // The head-to-head runs use one thread each.
+  std::vector<BoggleSolver*> one_solver(1, solvers[0]);
+  char threaded_name[20];
+  snprintf(threaded_name, sizeof(threaded_name), "climb-%d", num_threads);
+
+  std::vector<Result> anneals, climbs, threaded_climbs;
+  for (int trial = 0; trial < FLAGS_trials; trial++) {
+    anneals.push_back(RunAnnealer(solvers[0], FLAGS_rand_seed + trial));
+    Report("anneal", trial, anneals.back());
+    climbs.push_back(RunClimber(one_solver, FLAGS_rand_seed + trial));
+    Report("climb", trial, climbs.back());
+    if (num_threads > 1) {
+      threaded_climbs.push_back(RunClimber(solvers, FLAGS_rand_seed + trial));
+      Report(threaded_name, trial, threaded_climbs.back());
+    }
+  }
+
+  Summarize("anneal", anneals);
+  Summarize("climb", climbs);
+  if (num_threads > 1) {
+    printf("With %d threads:\n", num_threads);
+    Summarize(threaded_name, threaded_climbs);
+  }
+
+  for (int i = 0; i < solvers.size(); i++) delete solvers[i];
+}
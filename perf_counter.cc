@@ -0,0 +1,51 @@
+#include "perf_counter.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+CacheMissCounter::CacheMissCounter() : fd_(-1) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = PERF_COUNT_HW_CACHE_MISSES;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;  // Needed when perf_event_paranoid is 2.
+  attr.exclude_hv = 1;
+  fd_ = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  if (fd_ < 0) error_ = std::string("perf_event_open: ") + strerror(errno);
+}
+
+CacheMissCounter::~CacheMissCounter() {
+  if (fd_ >= 0) close(fd_);
+}
+
+void CacheMissCounter::Start() {
+  if (fd_ < 0) return;
+  ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+  ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+uint64_t CacheMissCounter::Stop() {
+  if (fd_ < 0) return 0;
+  ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+  uint64_t count = 0;
+  if (read(fd_, &count, sizeof(count)) != sizeof(count)) return 0;
+  return count;
+}
+
+#else
+
+CacheMissCounter::CacheMissCounter()
+    : fd_(-1), error_("perf_event_open is Linux-only") {}
+CacheMissCounter::~CacheMissCounter() {}
+void CacheMissCounter::Start() {}
+uint64_t CacheMissCounter::Stop() { return 0; }
+
+#endif
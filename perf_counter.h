@@ -0,0 +1,38 @@
+// Counts cache misses in the calling thread using perf_event_open(2).
+//
+// This is Linux-only, and even there the kernel may refuse, e.g. when
+// /proc/sys/kernel/perf_event_paranoid is too high or inside some containers.
+// In that case Available() is false and Error() says why.
+//
+// Typical usage:
+//   CacheMissCounter c;
+//   c.Start();
+//   ... do work ...
+//   if (c.Available()) printf("%llu misses\n", c.Stop());
+
+#ifndef PERF_COUNTER_H
+#define PERF_COUNTER_H
+
+#include <stdint.h>
+#include <string>
+
+class CacheMissCounter {
+ public:
+  CacheMissCounter();
+  ~CacheMissCounter();
+
+  bool Available() const { return fd_ >= 0; }
+  const std::string& Error() const { return error_; }
+
+  // Resets the count and starts counting.
+  void Start();
+
+  // Stops counting and returns the number of misses since Start().
+  uint64_t Stop();
+
+ private:
+  int fd_;
+  std::string error_;
+};
+
+#endif
@@ -12,6 +12,9 @@
 #include <vector>
 #include "boggle_solver.h"
 #include "bucket_solver.h"
+#include "family_scorer.h"
+#include "4x4/boggler.h"
+#include "board-utils.h"
 #include "glog/logging.h"
 #include "ibucket_breaker.h"
 #include "mtrandom/randomc.h"
@@ -217,14 +220,218 @@ bool TestBreaker(BucketSolver* solver_33,
   return true;
 }
 
+// Shedding letters before splitting should leave the same unbreakable boards.
+bool TestShedding() {
+  BucketSolver* solver = BucketSolver::Create(33, "words");
+  const char* classes[] = {
+    "st rt rt ae ae ae d lp lp",  // streaedlp and streeadlp score > 500.
+    "aeiou sy chlnrt st ae ae d lp lp",
+  };
+  for (int i = 0; i < sizeof(classes) / sizeof(*classes); i++) {
+    vector<string> failures[2];
+    for (int shed = 0; shed < 2; shed++) {
+      Breaker breaker(solver, 500);
+      BreakOptions opts;
+      opts.shed_letters = shed;
+      breaker.SetOptions(opts);
+      BreakDetails details;
+      if (!breaker.ParseBoard(classes[i])) {
+        fprintf(stderr, "Couldn't parse %s\n", classes[i]);
+        return false;
+      }
+      breaker.Break(&details);
+      if ((details.num_sheds > 0) != shed) {
+        fprintf(stderr, "Unexpected %d sheds on %s\n", details.num_sheds,
+                classes[i]);
+        return false;
+      }
+      failures[shed] = details.failures;
+      sort(failures[shed].begin(), failures[shed].end());
+    }
+    if (failures[0] != failures[1]) {
+      fprintf(stderr, "Shedding changed the failures on %s (%zu vs %zu)\n",
+              classes[i], failures[0].size(), failures[1].size());
+      return false;
+    }
+  }
+  delete solver;
+  return true;
+}
+
+// Scoring small classes exactly should find the same boards as splitting them.
+bool TestEnumeration() {
+  BucketSolver* solver = BucketSolver::Create(33, "words");
+  FamilyScorer scorer(Boggler::DictionaryFromFile("words"), 3, 3);
+  const char* bd_class = "st rt rt ae ae ae d lp lp";
+  vector<string> failures[2];
+  for (int enumerate = 0; enumerate < 2; enumerate++) {
+    Breaker breaker(solver, 500);
+    BreakOptions opts;
+    opts.enumerate_below = enumerate ? 64 : 0;
+    opts.scorer = &scorer;
+    breaker.SetOptions(opts);
+    BreakDetails details;
+    if (!breaker.ParseBoard(bd_class)) return false;
+    breaker.Break(&details);
+    if ((details.num_enumerated > 0) != enumerate) {
+      fprintf(stderr, "Unexpected %d enumerated classes\n",
+              details.num_enumerated);
+      return false;
+    }
+    failures[enumerate] = details.failures;
+    sort(failures[enumerate].begin(), failures[enumerate].end());
+  }
+  if (failures[0] != failures[1] || failures[0].size() != 2) {
+    fprintf(stderr, "Enumeration changed the failures (%zu vs %zu)\n",
+            failures[0].size(), failures[1].size());
+    return false;
+  }
+  delete solver;
+  return true;
+}
+
+// Skipping symmetric sub-classes should leave the same unbreakable boards, up
+// to rotation/reflection.
+bool TestSymmetry() {
+  BucketSolver* solver = BucketSolver::Create(33, "words");
+  BoardUtils bu(3, 3);
+  const char* classes[] = {
+    "aeiou st aeiou st chlnr st aeiou st aeiou",  // symmetric under all 8.
+    "st rt rt ae ae ae d lp lp",  // not symmetric at all.
+  };
+  for (int i = 0; i < sizeof(classes) / sizeof(*classes); i++) {
+    vector<string> failures[2];
+    int num_symmetric = 0;
+    for (int prune = 0; prune < 2; prune++) {
+      Breaker breaker(solver, i == 0 ? 150 : 500);
+      BreakOptions opts;
+      opts.prune_symmetric = prune;
+      breaker.SetOptions(opts);
+      BreakDetails details;
+      if (!breaker.ParseBoard(classes[i])) {
+        fprintf(stderr, "Couldn't parse %s\n", classes[i]);
+        return false;
+      }
+      breaker.Break(&details);
+      num_symmetric = details.num_symmetric;
+      for (int j = 0; j < details.failures.size(); j++) {
+        failures[prune].push_back(bu.Canonicalize(details.failures[j]));
+      }
+      sort(failures[prune].begin(), failures[prune].end());
+      failures[prune].erase(
+          unique(failures[prune].begin(), failures[prune].end()),
+          failures[prune].end());
+    }
+    if ((num_symmetric > 0) != (i == 0)) {
+      fprintf(stderr, "Unexpected %d symmetric classes on %s\n",
+              num_symmetric, classes[i]);
+      return false;
+    }
+    if (failures[0] != failures[1]) {
+      fprintf(stderr, "Symmetry changed the failures on %s (%zu vs %zu)\n",
+              classes[i], failures[0].size(), failures[1].size());
+      return false;
+    }
+  }
+  delete solver;
+  return true;
+}
+
+// Bounding with restricted dictionaries shouldn't change anything.
+bool TestRestrictTrie() {
+  BucketSolver* solver = BucketSolver::Create(33, "words");
+  SimpleTrie* dict = solver->Dictionary();
+  const char* bd_class = "aeiou sy chlnrt st ae ae d lp lp";
+  vector<string> failures[2];
+  for (int restrict = 0; restrict < 2; restrict++) {
+    Breaker breaker(solver, 200);
+    BreakOptions opts;
+    opts.restrict_trie = restrict;
+    breaker.SetOptions(opts);
+    BreakDetails details;
+    if (!breaker.ParseBoard(bd_class)) return false;
+    breaker.Break(&details);
+    if ((details.num_restricted > 0) != restrict) {
+      fprintf(stderr, "Unexpected %d restricted tries\n",
+              details.num_restricted);
+      return false;
+    }
+    if (solver->Dictionary() != dict) {
+      fprintf(stderr, "Breaker didn't restore the dictionary\n");
+      return false;
+    }
+    failures[restrict] = details.failures;
+    sort(failures[restrict].begin(), failures[restrict].end());
+  }
+  if (failures[0].empty() || failures[0] != failures[1]) {
+    fprintf(stderr, "Restricting changed the failures (%zu vs %zu)\n",
+            failures[0].size(), failures[1].size());
+    return false;
+  }
+  delete solver;
+  return true;
+}
+
+// Branch and bound should find the best board, and nothing when the starting
+// threshold is already the best score.
+bool TestFindBest() {
+  BucketSolver* solver = BucketSolver::Create(33, "words");
+  FamilyScorer scorer(Boggler::DictionaryFromFile("words"), 3, 3);
+  const char* bd_class = "st rt rt ae ae ae d lp lp";
+  int thresholds[] = { 0, 0, 545 };
+  uint64_t enumerate_below[] = { 0, 16, 0 };
+  for (int i = 0; i < 3; i++) {
+    Breaker breaker(solver, thresholds[i]);
+    BreakOptions opts;
+    opts.enumerate_below = enumerate_below[i];
+    opts.scorer = &scorer;
+    breaker.SetOptions(opts);
+    if (!breaker.ParseBoard(bd_class)) return false;
+    FindBestDetails details;
+    breaker.FindBest(&details);
+    string expected = (thresholds[i] < 545 ? "streaedlp" : "");
+    if (details.board != expected || details.score != 545) {
+      fprintf(stderr, "FindBest(%d) found '%s' (%d)\n", thresholds[i],
+              details.board.c_str(), details.score);
+      return false;
+    }
+  }
+  delete solver;
+  return true;
+}
+
 int main(int argc, char** argv) {
   Init(&argc, &argv);
+  bool ok = true;
 
   if (!TestRegular()) {
     fprintf(stderr, "%s: failed TestRegular\n", argv[0]);
+    ok = false;
   }
   if (!TestBuckets()) {
     fprintf(stderr, "%s: failed TestBuckets\n", argv[0]);
+    ok = false;
+  }
+  if (!TestShedding()) {
+    fprintf(stderr, "%s: failed TestShedding\n", argv[0]);
+    ok = false;
+  }
+  if (!TestEnumeration()) {
+    fprintf(stderr, "%s: failed TestEnumeration\n", argv[0]);
+    ok = false;
+  }
+  if (!TestSymmetry()) {
+    fprintf(stderr, "%s: failed TestSymmetry\n", argv[0]);
+    ok = false;
+  }
+  if (!TestRestrictTrie()) {
+    fprintf(stderr, "%s: failed TestRestrictTrie\n", argv[0]);
+    ok = false;
+  }
+  if (!TestFindBest()) {
+    fprintf(stderr, "%s: failed TestFindBest\n", argv[0]);
+    ok = false;
   }
+  if (!ok) return 1;
   printf("%s: Passed\n", argv[0]);
 }
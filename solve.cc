@@ -18,11 +18,43 @@ const char kUsage[] =
 "%s <dictionary file> [abcdefghijklmnop [qrstuvwxyzabcdef [...]]]\n"
 "A 'q' is treated as 'qu'.\n";
 
-DEFINE_string(dictionary, "words", "Dictionary file");
+DEFINE_string(dictionary, "words",
+              "Dictionary file. With a comma-separated list of files, each "
+              "board is scored against all of them in a single pass.");
 DEFINE_int32(size, 44, "Type of boggle board to use (MN = MxN)");
+DEFINE_int32(min_score, 0,
+             "If set, only print boards which score at least this much. "
+             "Scores aren't printed, but this is faster than solving fully.");
+DEFINE_int32(score_cache_size, 0,
+             "Cache the scores of this many recent boards (0 = no cache). "
+             "Boards which are rotations/reflections of one another share an "
+             "entry, so this helps with the output of neighbors.");
+DEFINE_bool(dafsa, false,
+            "Use a minimized automaton (DAFSA) for the dictionary rather than "
+            "a Trie. This takes much less memory, which helps with large "
+            "(e.g. merged) dictionaries and 4x4 boards.");
+DEFINE_bool(print_words, false,
+            "Print each word found on the board, with its points and the "
+            "cells used to spell it.");
 
 void HandleBoard(BoggleSolver* b, const char* bd);
 
+// Prints lines like "  tea 1 2-5-4" (word, points, cells).
+class WordPrinter : public WordVisitor {
+ public:
+  WordPrinter(BoggleSolver* b) : b_(b) {}
+  void FoundWord(int word_id, const int* path, int path_len, int points) {
+    printf("  %s %d ", b_->Word(word_id), points);
+    for (int i = 0; i < path_len; i++) {
+      printf("%s%d", i ? "-" : "", path[i]);
+    }
+    printf("\n");
+  }
+
+ private:
+  BoggleSolver* b_;
+};
+
 double secs() {
   struct timeval t;
   gettimeofday(&t, NULL);
@@ -32,16 +64,19 @@ double secs() {
 int main(int argc, char** argv) {
   Init(&argc, &argv);
 
-  FILE* f = fopen(FLAGS_dictionary.c_str(), "r");
-  if (f == NULL) {
-    fprintf(stderr, "Couldn't open dictionary file %s\n",
+  BoggleSolver* solver =
+    BoggleSolver::Create(FLAGS_size, FLAGS_dictionary.c_str(), FLAGS_dafsa);
+  if (!solver) {
+    fprintf(stderr, "Couldn't load dictionary %s\n",
             FLAGS_dictionary.c_str());
     exit(1);
   }
-  fclose(f);
-
-  BoggleSolver* solver =
-    BoggleSolver::Create(FLAGS_size, FLAGS_dictionary.c_str());
+  if (solver->NumDictionaries() > 1 &&
+      (FLAGS_min_score > 0 || FLAGS_print_words)) {
+    fprintf(stderr, "--min_score and --print_words take a single dictionary\n");
+    exit(1);
+  }
+  solver->SetScoreCacheSize(FLAGS_score_cache_size);
 
   if (argc > 1) {
     for (int i = 1; i < argc; i++) {
@@ -59,6 +94,11 @@ int main(int argc, char** argv) {
     auto elapsed_secs = end_secs - start_secs;
     auto rate = n / elapsed_secs;
     fprintf(stderr, "%d boards in %.2fs = %.2f boards/s\n", n, elapsed_secs, rate);
+    if (FLAGS_score_cache_size) {
+      fprintf(stderr, "score cache: %llu hits, %llu misses\n",
+              (unsigned long long)solver->CacheHits(),
+              (unsigned long long)solver->CacheMisses());
+    }
   }
 }
 
@@ -67,6 +107,24 @@ void HandleBoard(BoggleSolver* b, const char* bd) {
     fprintf(stderr, "Couldn't parse board string '%s'\n", bd);
     return;
   }
+  if (FLAGS_min_score > 0) {
+    if (b->ScoreAtLeast(FLAGS_min_score))
+      fprintf(stdout, "%s\n", b->ToString().c_str());
+    return;
+  }
+  if (b->NumDictionaries() > 1) {
+    int scores[SimpleTrie::kMaxDictionaries];
+    b->ScoreDictionaries(scores);
+    fprintf(stdout, "%s:", b->ToString().c_str());
+    for (int d = 0; d < b->NumDictionaries(); d++)
+      fprintf(stdout, " %d", scores[d]);
+    fprintf(stdout, "\n");
+    return;
+  }
   int score = b->Score();
   fprintf(stdout, "%s: %d\n", b->ToString().c_str(), score);
+  if (FLAGS_print_words) {
+    WordPrinter printer(b);
+    b->FindWords(&printer);
+  }
 }
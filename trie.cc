@@ -2,9 +2,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
 #include <queue>
+#include <unordered_map>
 #include <utility>
-#include <map>
 
 Trie::Trie() : bits_(0) {}
 
@@ -16,79 +19,127 @@ int NumChildren(const SimpleTrie& t) {
   return num_children;
 }
 
-// Memory model: The memory used by an entire Trie is owned by the root node of
-// that Trie. Since it would be expensive for each Trie node to remember
-// whether it's the root, we maintain a list of all root nodes and the memory
-// allocated for them.
-std::map<Trie*, char*> root_tries;
-
-// This is messy -- use placement new to get a Trie of the desired size.
-Trie* AllocatePT(const SimpleTrie& t, void* where, int* bytes_used) {
-  int mem_size = sizeof(Trie) +
-                 ((t.IsWord() ? 1 : 0) + ::NumChildren(t)) * sizeof(Trie*);
-  *bytes_used += mem_size;
-  return new(where) Trie;
-}
-
-// Allocate in BFS order to minimize parent/child spacing in memory.
-struct WorkItem {
-  const SimpleTrie& t;
-  Trie* pt;
-  int depth;
-  WorkItem(const SimpleTrie& tr,
-	   Trie* ptr, int d) : t(tr), pt(ptr), depth(d) {}
-};
-Trie* Trie::CompactTrie(const SimpleTrie& t) {
-  int alloced = 10 << 20;
-  char* root_mem = (char*)malloc(256);  // TODO: alloc the right amount.
-  char* raw_bytes = new char[alloced];  // TODO: figure out how much we need.
-  int bytes_used = 0;
+// Memory model: An entire Trie lives in one block of memory, with the root
+// node at the start. The root owns the block, so Delete() can free it without
+// any bookkeeping.
 
-  std::queue<WorkItem> todo;
-  Trie* root = AllocatePT(t, root_mem, &bytes_used);
-  bytes_used = 0;
-  root_tries.insert(std::make_pair(root, raw_bytes));
-  todo.push(WorkItem(t, root, 1));
+// Allocate in BFS order to minimize parent/child spacing in memory. The block
+// grows as needed, so while it's being built, nodes refer to their children
+// by offset. These are turned into pointers once the block stops moving.
+Trie* Trie::CompactTrie(const SimpleTrie& t) {
+  size_t capacity = 1 << 20;
+  char* mem = (char*)malloc(capacity);
+  if (!mem) return NULL;
+  size_t bytes_used = CompactNodeSize(t);
+  new(mem) Trie;
 
+  std::queue<std::pair<const SimpleTrie*, size_t> > todo;
+  todo.push(std::make_pair(&t, 0));
   while (!todo.empty()) {
-    WorkItem cur = todo.front();
+    const SimpleTrie& st = *todo.front().first;
+    size_t offset = todo.front().second;
     todo.pop();
 
-    // Construct the Trie in the Trie
-    const SimpleTrie& t = cur.t;
-    Trie* pt = cur.pt;
-    pt->SetIsWord(t.IsWord());
-    if (t.IsWord()) pt->Mark(0);
-    int num_written = 0;
-    int off = t.IsWord() ? 1 : 0;
-    for (int i=0; i<kNumLetters; i++) {
-      if (t.StartsWord(i)) {
-	pt->bits_ |= (1 << i);
-	pt->data_[off + num_written] =
-          (uintptr_t)AllocatePT(*t.Descend(i), raw_bytes + bytes_used, &bytes_used);
-	todo.push(WorkItem(*t.Descend(i), pt->Descend(i), cur.depth + 1));
-	num_written += 1;
-        if (bytes_used > alloced) {
-          fprintf(stderr, "Used too much memory!");
-          return NULL;
-        }
+    // Make sure there's room for the largest possible set of children.
+    const size_t kMaxChildrenSize =
+        kNumLetters * (sizeof(Trie) + (1 + kNumLetters) * sizeof(Trie*));
+    if (bytes_used + kMaxChildrenSize > capacity) {
+      capacity *= 2;
+      char* bigger = (char*)realloc(mem, capacity);
+      if (!bigger) {
+        free(mem);
+        return NULL;
       }
+      mem = bigger;
+    }
+
+    Trie* pt = (Trie*)(mem + offset);
+    pt->SetIsWord(st.IsWord());
+    if (st.IsWord()) pt->Mark(0);
+    int off = st.IsWord() ? 1 : 0;
+    for (int i = 0; i < kNumLetters; i++) {
+      if (!st.StartsWord(i)) continue;
+      const SimpleTrie* child = st.Descend(i);
+      new(mem + bytes_used) Trie;
+      pt->bits_ |= (1 << i);
+      pt->data_[off++] = bytes_used;
+      todo.push(std::make_pair(child, bytes_used));
+      bytes_used += CompactNodeSize(*child);
     }
   }
-  return root;
+
+  // The nodes are back to back, so they can be fixed up in one pass.
+  char* fit = (char*)realloc(mem, bytes_used);
+  if (fit) mem = fit;
+  for (size_t offset = 0; offset < bytes_used; ) {
+    Trie* pt = (Trie*)(mem + offset);
+    int off = pt->IsWord() ? 1 : 0;
+    int num_children = pt->NumChildren();
+    for (int i = 0; i < num_children; i++)
+      pt->data_[off + i] += (uintptr_t)mem;
+    offset += sizeof(Trie) + (off + num_children) * sizeof(Trie*);
+  }
+  return (Trie*)mem;
 }
 
-// Free memory associated with this Trie, if it owns any memory.
-void Trie::Delete() {
-  this->~Trie();  // free the memory owned by this Trie.
-  free(this);     // free the memory used by this node.
+size_t Trie::CompactNodeSize(const SimpleTrie& t) {
+  return sizeof(Trie) +
+         ((t.IsWord() ? 1 : 0) + ::NumChildren(t)) * sizeof(Trie*);
 }
-Trie::~Trie() {
-  std::map<Trie*, char*>::iterator it = root_tries.find(this);
-  if (it != root_tries.end()) {
-    delete[] it->second;
-    root_tries.erase(it);
+
+Trie* Trie::CompactTrie(const SimpleTrie& t,
+                        const std::vector<const SimpleTrie*>& hot) {
+  // Decide where every node other than the root goes: hot nodes first, then
+  // everything else in BFS order.
+  std::vector<const SimpleTrie*> order;
+  std::unordered_map<const SimpleTrie*, size_t> offsets;
+  size_t bytes = CompactNodeSize(t);
+  for (int i = 0; i < hot.size(); i++) {
+    if (hot[i] == &t || offsets.count(hot[i])) continue;
+    offsets[hot[i]] = bytes;
+    bytes += CompactNodeSize(*hot[i]);
+    order.push_back(hot[i]);
+  }
+  std::queue<const SimpleTrie*> todo;
+  todo.push(&t);
+  while (!todo.empty()) {
+    const SimpleTrie* cur = todo.front();
+    todo.pop();
+    for (int i = 0; i < kNumLetters; i++) {
+      if (!cur->StartsWord(i)) continue;
+      const SimpleTrie* child = cur->Descend(i);
+      todo.push(child);
+      if (offsets.count(child)) continue;
+      offsets[child] = bytes;
+      bytes += CompactNodeSize(*child);
+      order.push_back(child);
+    }
+  }
+
+  // As in CompactTrie(t), the root comes first and owns the block.
+  char* raw_bytes = (char*)malloc(bytes);
+  if (!raw_bytes) return NULL;
+  Trie* root = new(raw_bytes) Trie;
+
+  order.insert(order.begin(), &t);
+  for (int n = 0; n < order.size(); n++) {
+    const SimpleTrie& st = *order[n];
+    Trie* pt = n ? new(raw_bytes + offsets[&st]) Trie : root;
+    pt->SetIsWord(st.IsWord());
+    if (st.IsWord()) pt->Mark(0);
+    int off = st.IsWord() ? 1 : 0;
+    for (int i = 0; i < kNumLetters; i++) {
+      if (!st.StartsWord(i)) continue;
+      pt->bits_ |= (1 << i);
+      pt->data_[off++] = (uintptr_t)(raw_bytes + offsets[st.Descend(i)]);
+    }
   }
+  return root;
+}
+
+// The root node is at the start of the block holding the whole Trie.
+void Trie::Delete() {
+  free(this);
 }
 
 // Utility routines that operate on the root Trie node.
@@ -107,7 +158,7 @@ bool Trie::IsWord(const char* wd) const {
 
 size_t Trie::MemoryUsage() const {
   size_t size = sizeof(*this);
-  if (IsWord()) size += sizeof(unsigned);
+  if (IsWord()) size += sizeof(uintptr_t);  // the mark
   size += sizeof(Trie*) * NumChildren();
   for (int i = 0; i < 26; i++) {
     if (StartsWord(i))
@@ -157,21 +208,128 @@ SimpleTrie* SimpleTrie::AddWord(const char* wd) {
     return this;
   }
   int c = idx(*wd);
-  if (!StartsWord(c))
-    children_[c] = new SimpleTrie;
+  if (!StartsWord(c)) {
+    children_[c] = arena_->NewNode();
+    bits_ |= (1 << c);
+  }
   return Descend(c)->AddWord(wd+1);
 }
 
-SimpleTrie::~SimpleTrie() {
-  for (int i=0; i<26; i++) {
-    if (children_[i]) delete children_[i];
+SimpleTrie* SimpleTrie::Restrict(const int max_uses[26]) const {
+  int uses[26];
+  memcpy(uses, max_uses, sizeof(uses));
+  SimpleTrie* t = new SimpleTrie;
+  RestrictSubtrie(uses, t->arena_, t);
+  return t;
+}
+
+SimpleTrie* SimpleTrie::RestrictSubtrie(int max_uses[26], Arena* arena,
+                                        SimpleTrie* t) const {
+  for (int i = 0; i < kNumLetters; i++) {
+    if (!StartsWord(i) || !max_uses[i]) continue;
+    max_uses[i] -= 1;
+    SimpleTrie* child = Descend(i)->RestrictSubtrie(max_uses, arena, NULL);
+    max_uses[i] += 1;
+    if (!child) continue;
+    if (!t) t = arena->NewNode();
+    t->children_[i] = child;
+    t->bits_ |= (1 << i);
+  }
+  if (IsWord()) {
+    if (!t) t = arena->NewNode();
+    t->SetIsWord();
+    t->bits_ |= (Dictionaries() << 27);
   }
+  return t;
+}
+
+// The nodes themselves own nothing, so only the root's destructor does
+// anything.
+SimpleTrie::~SimpleTrie() {
+  if (arena_->owner_ == this) delete arena_;
 }
 
 // Initially, this node is empty
 SimpleTrie::SimpleTrie() {
   for (int i=0; i<kNumLetters; i++)
     children_[i] = NULL;
-  is_word_ = false;
+  bits_ = 0;
+  word_id_ = -1;
+  mark_ = 0;
+  arena_ = new Arena;
+  arena_->owner_ = this;
+}
+
+SimpleTrie::SimpleTrie(Arena* arena) {
+  for (int i=0; i<kNumLetters; i++)
+    children_[i] = NULL;
+  bits_ = 0;
+  word_id_ = -1;
   mark_ = 0;
+  arena_ = arena;
+}
+
+
+// SimpleTrie::Arena
+SimpleTrie::Arena::Arena()
+    : owner_(NULL), chunk_nodes_(0), next_(NULL), left_(0) {}
+
+SimpleTrie::Arena::~Arena() {
+  for (int i = 0; i < chunks_.size(); i++) free(chunks_[i]);
+  for (int i = 0; i < adopted_.size(); i++) delete adopted_[i];
+}
+
+SimpleTrie* SimpleTrie::Arena::NewNode() {
+  if (!left_) {
+    // Small Tries, e.g. from Restrict(), shouldn't need a whole big chunk.
+    chunk_nodes_ = chunk_nodes_ ? std::min(2 * chunk_nodes_, kMaxChunkNodes)
+                                : 16;
+    next_ = (char*)malloc(chunk_nodes_ * sizeof(SimpleTrie));
+    if (!next_) throw std::bad_alloc();
+    chunks_.push_back(next_);
+    left_ = chunk_nodes_;
+  }
+  SimpleTrie* t = new(next_) SimpleTrie(this);
+  next_ += sizeof(SimpleTrie);
+  left_ -= 1;
+  return t;
+}
+
+void SimpleTrie::Arena::Adopt(Arena* other) {
+  other->owner_ = NULL;
+  adopted_.push_back(other);
+}
+
+size_t SimpleTrie::Arena::BytesAllocated() const {
+  size_t bytes = 0;
+  int nodes = 16;
+  for (int i = 0; i < chunks_.size(); i++) {
+    bytes += nodes * sizeof(SimpleTrie);
+    nodes = std::min(2 * nodes, kMaxChunkNodes);
+  }
+  for (int i = 0; i < adopted_.size(); i++)
+    bytes += adopted_[i]->BytesAllocated();
+  return bytes;
+}
+
+
+// WordTable
+WordTable::WordTable(SimpleTrie* t) {
+  std::string prefix;
+  AddWords(t, &prefix);
+}
+
+void WordTable::AddWords(SimpleTrie* t, std::string* prefix) {
+  if (t->IsWord()) {
+    t->SetWordId(offsets_.size());
+    offsets_.push_back(chars_.size());
+    chars_.insert(chars_.end(), prefix->begin(), prefix->end());
+    chars_.push_back('\0');
+  }
+  for (int i = 0; i < kNumLetters; i++) {
+    if (!t->StartsWord(i)) continue;
+    prefix->append(i == kQ ? "qu" : std::string(1, 'a' + i));
+    AddWords(t->Descend(i), prefix);
+    prefix->resize(prefix->size() - (i == kQ ? 2 : 1));
+  }
 }
@@ -24,20 +24,28 @@ class Trie {
   Trie();
   
   // Call "trie->Delete()" rather than "delete trie" on the root node of a
-  // Trie. I'm sorry, it just needs to be this way.
-  // ~Trie();
+  // Trie. I'm sorry, it just needs to be this way. This frees the whole Trie,
+  // which is one block of memory starting with the root.
   void Delete();
 
   // Fast operations
   bool IsWord() const { return bits_ & (1 << 26); }
   bool StartsWord(int i) const { return bits_ & (1 << i); }
-  int NumChildren() const { return CountBits(bits_ & ((1<<26) - 1)); }
+  int NumChildren() const { return CountBits(ChildMask()); }
+
+  // Bit i is set if StartsWord(i).
+  uint32_t ChildMask() const { return bits_ & ((1 << 26) - 1); }
 
   Trie* Descend(int i) const {
     uint32_t v = bits_ & ((1 << i) - 1);
     return (Trie*)data_[(IsWord() ? Marks : 0) + CountBits(v)];
   }
 
+  // Hint that Descend(i) will be needed soon.
+  void PrefetchChild(int i) const {
+    if (StartsWord(i)) __builtin_prefetch(Descend(i));
+  }
+
   // NOTE: These should NEVER be called unless this Node is already a word.
   void Mark(uintptr_t mark) { data_[0] = mark; }
   uintptr_t Mark() { return data_[0]; }
@@ -46,8 +54,18 @@ class Trie {
   bool IsWord(const char* wd) const;
   void SetIsWord(bool w) { bits_ &= ~(1<<26); bits_ |= (w << 26); }
 
-  // Trie-building methods (slow)
+  // Trie-building methods (slow). These return NULL if they run out of
+  // memory.
   static Trie* CompactTrie(const SimpleTrie& t);
+
+  // Like CompactTrie(t), but the nodes in hot are laid out first, in the
+  // order given, and the rest follow in BFS order. hot should consist of nodes
+  // of t, e.g. the most-visited ones from a TrieProfile.
+  static Trie* CompactTrie(const SimpleTrie& t,
+                           const std::vector<const SimpleTrie*>& hot);
+
+  // Number of bytes that CompactTrie() uses for the node corresponding to t.
+  static size_t CompactNodeSize(const SimpleTrie& t);
   static Trie* CreateFromFile(const char* file);
 
   // Analysis (slow)
@@ -70,21 +88,70 @@ class Trie {
     return v;
   }
 
-  ~Trie();
+  ~Trie() {}
 };
 
 // Plain vanilla trie used for bootstrapping the Trie.
 //template<int Marks>
 class SimpleTrie {
  public:
+  // Owns the nodes of a SimpleTrie. Nodes are carved out of chunks (which
+  // grow, up to kMaxChunkNodes nodes) rather than malloc'd one at a time,
+  // which makes building a big Trie faster and keeps the nodes of a word
+  // close together. An Arena isn't thread-safe, so to build a Trie in
+  // parallel, give each thread its own and have the root Adopt() them.
+  class Arena {
+   public:
+    Arena();
+    // Frees every node from this Arena and from the ones it has adopted.
+    ~Arena();
+
+    // A new, empty node whose children will come from this Arena.
+    SimpleTrie* NewNode();
+
+    // Takes ownership of other, so that its nodes live as long as ours.
+    void Adopt(Arena* other);
+
+    // Bytes allocated for nodes, including those of adopted Arenas.
+    size_t BytesAllocated() const;
+
+   private:
+    friend class SimpleTrie;
+    static const int kMaxChunkNodes = 4096;
+
+    const SimpleTrie* owner_;  // the root which deletes this Arena, if any.
+    std::vector<char*> chunks_;
+    int chunk_nodes_;  // size of the last chunk, in nodes.
+    char* next_;
+    int left_;  // nodes left in the last chunk.
+    std::vector<Arena*> adopted_;
+
+    Arena(const Arena&);
+    void operator=(const Arena&);
+  };
+
+  // An empty Trie, which owns a new Arena for its nodes. Deleting it frees
+  // the whole Trie. Don't delete any other node.
   SimpleTrie();
   ~SimpleTrie();
 
   bool StartsWord(int i) const { return children_[i]; }
   SimpleTrie* Descend(int i) const { return children_[i]; }
+  // Hint that Descend(i) will be needed soon. Fine to call on a NULL child.
+  void PrefetchChild(int i) const { __builtin_prefetch(children_[i]); }
+
+  bool IsWord() const { return bits_ & (1 << 26); }
+  void SetIsWord() { bits_ |= (1 << 26); }
+
+  // Bit i is set if StartsWord(i).
+  uint32_t ChildMask() const { return bits_ & ((1 << 26) - 1); }
 
-  bool IsWord() const { return is_word_; }
-  void SetIsWord() { is_word_ = true; }
+  // A Trie can merge several dictionaries (see Boggler::DictionaryFromFiles).
+  // Bit d of Dictionaries() is set if this word is in dictionary d. These
+  // live in the otherwise unused high bits of bits_.
+  static const int kMaxDictionaries = 5;
+  uint32_t Dictionaries() const { return bits_ >> 27; }
+  void AddDictionary(int d) { bits_ |= (1u << (27 + d)); }
 
   void Mark(uintptr_t m) { mark_ = m; }
   uintptr_t Mark() { return mark_; }
@@ -92,12 +159,67 @@ class SimpleTrie {
   // Returns a pointer to the new Trie node at the end of the word.
   SimpleTrie* AddWord(const char* wd);
 
+  // Makes t the child for letter i, which this node mustn't have already.
+  // This is for joining Tries built separately. t's nodes must come from
+  // GetArena() or an Arena it has adopted.
+  void SetChild(int i, SimpleTrie* t) {
+    children_[i] = t;
+    bits_ |= (1 << i);
+  }
+
+  // The Arena which new children of this node come from.
+  Arena* GetArena() const { return arena_; }
+
+  // Returns a new Trie with just the words which use each letter i at most
+  // max_uses[i] times, e.g. the words which could be found on a board where
+  // letter i is on max_uses[i] cells. Marks and word ids aren't copied, but
+  // the dictionaries each word is in are.
+  SimpleTrie* Restrict(const int max_uses[26]) const;
+
+  // Dense ids for words, assigned by a WordTable. -1 until then.
+  int32_t WordId() const { return word_id_; }
+  void SetWordId(int32_t id) { word_id_ = id; }
+
  private:
-  bool is_word_;
+  explicit SimpleTrie(Arena* arena);
+  SimpleTrie(const SimpleTrie&);
+  void operator=(const SimpleTrie&);
+
+  // Copies the restricted words below this node into t, which is allocated
+  // from arena if it's NULL. Returns NULL, rather than an empty node, if no
+  // words are left.
+  SimpleTrie* RestrictSubtrie(int max_uses[26], Arena* arena,
+                              SimpleTrie* t) const;
+
+  // children (bits 0-25) and word-ness (bit 26), as in Trie, then the
+  // dictionaries (bits 27-31).
+  uint32_t bits_;
+  int32_t word_id_;  // fits in what would otherwise be padding.
   uintptr_t mark_;
+  Arena* arena_;
   SimpleTrie* children_[26];
 };
 
+// Numbers the words in a SimpleTrie 0..n-1 in alphabetical order and maps
+// the numbers back to words. Looking up a word is O(1), rather than searching
+// the whole Trie as TrieUtils::ReverseLookup does.
+class WordTable {
+ public:
+  // Sets the word id of every word in t.
+  explicit WordTable(SimpleTrie* t);
+
+  int NumWords() const { return offsets_.size(); }
+
+  // The word with the given id, with a 'q' in the Trie spelled out as "qu".
+  const char* Word(int id) const { return &chars_[offsets_[id]]; }
+
+ private:
+  void AddWords(SimpleTrie* t, std::string* prefix);
+
+  std::vector<char> chars_;  // null-terminated words, back to back.
+  std::vector<int> offsets_;  // id -> start of word in chars_.
+};
+
 // Some statistics:
 // - 172203 words
 // - 385272 nodes
@@ -125,7 +247,7 @@ class TrieUtils {
     ReverseLookup(base, child, &out);
     return out;
   }
-  static void SetAllMarks(TrieT* t, unsigned mark);
+  static void SetAllMarks(TrieT* t, uintptr_t mark);
   static void PrintTrie(std::string prefix = "");
   static TrieT* FindWord(TrieT* t, const char* wd);
 };
@@ -164,7 +286,7 @@ bool TrieUtils<TrieT>::ReverseLookup(const TrieT* base, const TrieT* child,
 }
 
 template<class TrieT>
-void TrieUtils<TrieT>::SetAllMarks(TrieT* t, unsigned mark) {
+void TrieUtils<TrieT>::SetAllMarks(TrieT* t, uintptr_t mark) {
   if (t->IsWord()) t->Mark(mark);
   for (int i=0; i<kNumLetters; i++) {
     if (t->StartsWord(i)) SetAllMarks(t->Descend(i), mark);
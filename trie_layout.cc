@@ -0,0 +1,182 @@
+// Build a profile-guided layout for the compact Trie.
+//
+// Runs a corpus of boards through a solver, counting how often each Trie node
+// is visited. The most-visited nodes (up to --hot_bytes of them) are packed
+// together at the start of a compact Trie, hottest first, with everything else
+// following in the usual BFS order. The idea is for the nodes that the solver
+// actually touches to fit in L2.
+//
+// Boards are read from the command line or stdin, one per line:
+//
+//   $ ./random_boards -n 100000 | ./trie_layout --layout_file hot.txt
+//
+// The corpus is then scored using both the plain BFS layout and the profiled
+// one, and the times are compared. The hot nodes are written to --layout_file,
+// which TrieProfile::ReadLayout() can apply to a freshly-loaded dictionary.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "3x3/boggler.h"
+#include "3x4/boggler.h"
+#include "4x4/boggler.h"
+#include "boggle_solver.h"
+#include "gflags/gflags.h"
+#include "init.h"
+#include "trie.h"
+#include "trie_profile.h"
+
+DEFINE_string(dictionary, "words", "Dictionary file");
+DEFINE_int32(size, 44, "Type of boggle board to use (MN = MxN)");
+DEFINE_int32(hot_bytes, 512 << 10,
+             "Size of the hot region at the start of the Trie, in bytes");
+DEFINE_string(layout_file, "",
+              "If set, write the prefixes of the hot nodes to this file");
+DEFINE_int32(reps, 3, "Time the best of this many passes over the corpus");
+
+using std::string;
+using std::vector;
+
+double secs() {
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+// Scores boards using a compact Trie, with the solvers' iterative DFS. The
+// Bogglers only work with SimpleTries. A compact Trie has no word ids or
+// dictionaries, so FindWords() and ScoreDictionaries() aren't supported.
+class CompactBoggler : public BoggleSolver {
+ public:
+  CompactBoggler(Trie* t, int w, int h) : dict_(t), w_(w), h_(h) {
+    TrieUtils<Trie>::SetAllMarks(dict_, 0);
+    FindNeighbors(w_, h_, neighbors_, num_neighbors_);
+    for (int i = 0; i < w_ * h_; i++) bd_[i] = 0;
+  }
+
+  int Width() const { return w_; }
+  int Height() const { return h_; }
+  void SetCell(int x, int y, int c) { bd_[x * h_ + y] = c; }
+  int Cell(int x, int y) const { return bd_[x * h_ + y]; }
+  void FindWords(WordVisitor* v) {}
+  const char* Word(int word_id) { return ""; }
+
+ protected:
+  int InternalScore() { return Search<false>(0); }
+  int InternalScoreAtLeast(int threshold) { return Search<true>(threshold); }
+  void ResetMarks() { TrieUtils<Trie>::SetAllMarks(dict_, 0); }
+  void InternalScoreDictionaries(int* scores) {}
+
+ private:
+  template<bool EarlyExit> int Search(int threshold) {
+    NeighborLetterMasks(w_ * h_, bd_, neighbors_, num_neighbors_, nbr_mask_);
+    return IterativeSearch<EarlyExit>(dict_, bd_, w_ * h_, neighbors_,
+                                      num_neighbors_, nbr_mask_, threshold);
+  }
+
+  Trie* dict_;
+  int w_, h_;
+  int bd_[16];
+  int neighbors_[16][8];
+  int num_neighbors_[16];
+  uint32_t nbr_mask_[16];
+};
+
+// Scores the corpus reps times and returns the fastest time. Sets *total to
+// the sum of the scores.
+double TimeCorpus(Trie* t, const vector<string>& boards, int* total) {
+  CompactBoggler solver(t, FLAGS_size / 10, FLAGS_size % 10);
+  double best = -1;
+  for (int rep = 0; rep < FLAGS_reps; rep++) {
+    double start = secs();
+    *total = 0;
+    for (int i = 0; i < boards.size(); i++) {
+      *total += solver.Score(boards[i].c_str());
+    }
+    double elapsed = secs() - start;
+    if (best < 0 || elapsed < best) best = elapsed;
+  }
+  return best;
+}
+
+int main(int argc, char** argv) {
+  Init(&argc, &argv);
+
+  SimpleTrie* t = Boggler::DictionaryFromFile(FLAGS_dictionary.c_str());
+  if (!t) exit(1);
+
+  // The solver takes ownership of t.
+  BoggleSolver* solver = NULL;
+  switch (FLAGS_size) {
+    case 33: solver = new Boggler3(t); break;
+    case 34: solver = new Boggler34(t); break;
+    case 44: solver = new Boggler(t); break;
+    default:
+      fprintf(stderr, "Unknown board size: %d\n", FLAGS_size);
+      exit(1);
+  }
+
+  vector<string> boards;
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) boards.push_back(argv[i]);
+  } else {
+    string s;
+    while (std::cin >> s) boards.push_back(s);
+  }
+
+  TrieProfile profile(t, solver);
+  vector<string> good_boards;
+  for (int i = 0; i < boards.size(); i++) {
+    // ParseBoard() complains about bad boards.
+    if (profile.AddBoard(boards[i].c_str())) good_boards.push_back(boards[i]);
+  }
+  if (good_boards.empty()) {
+    fprintf(stderr, "No boards to profile.\n");
+    exit(1);
+  }
+
+  vector<const SimpleTrie*> hot;
+  profile.HotNodes(FLAGS_hot_bytes, &hot);
+  uint64_t total_visits = 0, hot_visits = 0;
+  size_t hot_size = 0;
+  for (int i = 0; i < hot.size(); i++) {
+    hot_visits += profile.Visits(hot[i]);
+    hot_size += Trie::CompactNodeSize(*hot[i]);
+  }
+  vector<const SimpleTrie*> all;
+  profile.HotNodes(~(size_t)0, &all);
+  for (int i = 0; i < all.size(); i++) total_visits += profile.Visits(all[i]);
+
+  printf("Profiled %d boards: %zu of %zu nodes visited\n",
+         profile.NumBoards(), profile.NumVisitedNodes(),
+         TrieUtils<SimpleTrie>::NumNodes(t));
+  printf("Hot region: %zu nodes, %zu bytes, %.1f%% of visits\n",
+         hot.size(), hot_size, 100.0 * hot_visits / total_visits);
+
+  if (!FLAGS_layout_file.empty()) {
+    if (!TrieProfile::WriteLayout(FLAGS_layout_file.c_str(), t, hot)) exit(1);
+  }
+
+  Trie* bfs = Trie::CompactTrie(*t);
+  Trie* profiled = Trie::CompactTrie(*t, hot);
+  int bfs_total, profiled_total;
+  double bfs_secs = TimeCorpus(bfs, good_boards, &bfs_total);
+  double profiled_secs = TimeCorpus(profiled, good_boards, &profiled_total);
+  if (bfs_total != profiled_total) {
+    fprintf(stderr, "Score mismatch: %d (BFS) != %d (profiled)\n",
+            bfs_total, profiled_total);
+    exit(1);
+  }
+  printf("BFS layout:      %.3fs = %.0f bds/sec\n",
+         bfs_secs, good_boards.size() / bfs_secs);
+  printf("Profiled layout: %.3fs = %.0f bds/sec\n",
+         profiled_secs, good_boards.size() / profiled_secs);
+
+  bfs->Delete();
+  profiled->Delete();
+  delete solver;
+}
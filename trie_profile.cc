@@ -0,0 +1,105 @@
+#include "trie_profile.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <queue>
+#include <string>
+#include <utility>
+
+TrieProfile::TrieProfile(const SimpleTrie* t, BoggleSolver* solver)
+    : dict_(t), solver_(solver), num_boards_(0) {}
+
+bool TrieProfile::AddBoard(const char* bd) {
+  if (!solver_->ParseBoard(bd)) return false;
+  visits_[dict_] += 1;
+  solver_->FindWords(this);
+  num_boards_ += 1;
+  return true;
+}
+
+uint64_t TrieProfile::Visits(const SimpleTrie* t) const {
+  std::unordered_map<const SimpleTrie*, uint64_t>::const_iterator it =
+      visits_.find(t);
+  return it == visits_.end() ? 0 : it->second;
+}
+
+void TrieProfile::HotNodes(size_t max_bytes,
+                           std::vector<const SimpleTrie*>* out) const {
+  // Grow the set from the root, always taking the hottest node whose parent
+  // has already been taken. Ties go to the node which became available first.
+  typedef std::pair<uint64_t, int64_t> Key;  // (visits, -order)
+  std::priority_queue<std::pair<Key, const SimpleTrie*> > frontier;
+  int64_t order = 0;
+  frontier.push(std::make_pair(Key(Visits(dict_), order--), dict_));
+
+  out->clear();
+  size_t bytes = 0;
+  while (!frontier.empty()) {
+    const SimpleTrie* t = frontier.top().second;
+    uint64_t count = frontier.top().first.first;
+    frontier.pop();
+    if (!count) break;
+    bytes += Trie::CompactNodeSize(*t);
+    if (bytes > max_bytes) break;
+    out->push_back(t);
+    for (int i = 0; i < kNumLetters; i++) {
+      if (!t->StartsWord(i)) continue;
+      const SimpleTrie* child = t->Descend(i);
+      frontier.push(std::make_pair(Key(Visits(child), order--), child));
+    }
+  }
+}
+
+static void FindPrefixes(const SimpleTrie* t, std::string* prefix,
+                         std::unordered_map<const SimpleTrie*,
+                                            std::string>* out) {
+  (*out)[t] = *prefix;
+  for (int i = 0; i < kNumLetters; i++) {
+    if (!t->StartsWord(i)) continue;
+    prefix->push_back('a' + i);
+    FindPrefixes(t->Descend(i), prefix, out);
+    prefix->resize(prefix->size() - 1);
+  }
+}
+
+bool TrieProfile::WriteLayout(const char* filename, const SimpleTrie* root,
+                              const std::vector<const SimpleTrie*>& nodes) {
+  std::unordered_map<const SimpleTrie*, std::string> prefixes;
+  std::string prefix;
+  FindPrefixes(root, &prefix, &prefixes);
+
+  FILE* f = fopen(filename, "w");
+  if (!f) {
+    fprintf(stderr, "Couldn't open %s\n", filename);
+    return false;
+  }
+  for (int i = 0; i < nodes.size(); i++) {
+    // The root's prefix is empty, so it's written as "-".
+    const std::string& p = prefixes[nodes[i]];
+    fprintf(f, "%s\n", p.empty() ? "-" : p.c_str());
+  }
+  fclose(f);
+  return true;
+}
+
+bool TrieProfile::ReadLayout(const char* filename, const SimpleTrie* root,
+                             std::vector<const SimpleTrie*>* nodes) {
+  FILE* f = fopen(filename, "r");
+  if (!f) {
+    fprintf(stderr, "Couldn't open %s\n", filename);
+    return false;
+  }
+  nodes->clear();
+  char line[80];
+  while (fscanf(f, "%79s", line) == 1) {
+    const SimpleTrie* t = root;
+    for (const char* c = line; *c && *c != '-' && t; c++) {
+      int i = *c - 'a';
+      t = (i >= 0 && i < kNumLetters && t->StartsWord(i)) ? t->Descend(i)
+                                                          : NULL;
+    }
+    if (t) nodes->push_back(t);
+  }
+  fclose(f);
+  return true;
+}
@@ -0,0 +1,75 @@
+// Count how often each node of a SimpleTrie is visited while solving boards.
+//
+// A solver only touches a small part of the Trie, mostly the prefixes of
+// common letter combinations. Laying those nodes out next to one another with
+// Trie::CompactTrie(t, hot) keeps the working set small enough to stay in
+// cache. The nodes are counted by a solver's FindWords(), so the profile
+// follows the same search as scoring. Typical usage:
+//
+//   SimpleTrie* t = Boggler::DictionaryFromFile("words");
+//   Boggler b(t);
+//   TrieProfile p(t, &b);
+//   for (...) p.AddBoard(bd);
+//   std::vector<const SimpleTrie*> hot;
+//   p.HotNodes(256 << 10, &hot);
+//   Trie* pt = Trie::CompactTrie(*t, hot);
+//
+// The layout can be saved with WriteLayout() and applied to a freshly-loaded
+// dictionary with ReadLayout().
+//
+// This is experimental: none of the Bogglers search a compact Trie, so the
+// profiled layout is only used by trie_layout's own solver, where it hasn't
+// measurably beaten the plain BFS layout.
+
+#ifndef TRIE_PROFILE_H
+#define TRIE_PROFILE_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "boggle_solver.h"
+#include "trie.h"
+
+class TrieProfile : public WordVisitor {
+ public:
+  // Profiles the searches of solver, whose dictionary must be t. Doesn't take
+  // ownership of either.
+  TrieProfile(const SimpleTrie* t, BoggleSolver* solver);
+
+  // Counts the nodes visited by a search of the board, which is a board
+  // string for the solver. Returns false on a bad board string.
+  bool AddBoard(const char* bd);
+
+  uint64_t Visits(const SimpleTrie* t) const;
+  size_t NumVisitedNodes() const { return visits_.size(); }
+  int NumBoards() const { return num_boards_; }
+
+  // The hottest nodes whose compact representation fits in max_bytes. These
+  // form a subtree: a node is only taken once its parent has been, since a
+  // node can be visited more often than its parent (once per cell with its
+  // letter). Each node comes after its parent.
+  void HotNodes(size_t max_bytes, std::vector<const SimpleTrie*>* out) const;
+
+  // Writes the prefixes of the nodes, one per line. Returns false on error.
+  static bool WriteLayout(const char* filename, const SimpleTrie* root,
+                          const std::vector<const SimpleTrie*>& nodes);
+
+  // Reads a file from WriteLayout() and finds the nodes in root. Prefixes
+  // which aren't in root are skipped.
+  static bool ReadLayout(const char* filename, const SimpleTrie* root,
+                         std::vector<const SimpleTrie*>* nodes);
+
+  virtual void FoundWord(int word_id, const int* path, int path_len,
+                         int points) {}
+  virtual void VisitNode(const void* node) {
+    visits_[static_cast<const SimpleTrie*>(node)] += 1;
+  }
+
+ private:
+  const SimpleTrie* dict_;
+  BoggleSolver* solver_;
+  int num_boards_;
+  std::unordered_map<const SimpleTrie*, uint64_t> visits_;
+};
+
+#endif
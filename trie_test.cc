@@ -5,7 +5,9 @@
 #include <string>
 #include <vector>
 
+#include "3x3/boggler.h"
 #include "trie.h"
+#include "trie_profile.h"
 
 int main(int argc, char** argv) {
   char tmp_file[] = "/tmp/trie-words.XXXXXX";
@@ -50,8 +52,154 @@ int main(int argc, char** argv) {
     assert(0 == wd->Mark());
     wd->Mark(12345);
     assert(12345 == wd->Mark());
+
+    // "tea" continues with 'p' in "teapot" only.
+    assert((1u << ('p' - 'a')) == wd->ChildMask());
+    assert(((1u << ('a' - 'a')) | (1u << ('b' - 'a')) | (1u << ('c' - 'a')) |
+            (1u << ('s' - 'a')) | (1u << ('t' - 'a'))) == t->ChildMask());
     t->Delete();
   }
   assert(0 == remove(tmp_file));
+
+  SimpleTrie st;
+  assert(0 == st.ChildMask());
+  st.AddWord("tea");
+  st.AddWord("tip");
+  assert(!st.IsWord());
+  assert((1u << ('t' - 'a')) == st.ChildMask());
+  SimpleTrie* te = st.Descend('t' - 'a');
+  assert(((1u << ('e' - 'a')) | (1u << ('i' - 'a'))) == te->ChildMask());
+  assert(te->Descend('e' - 'a')->Descend('a' - 'a')->IsWord());
+  assert(0 == te->Descend('e' - 'a')->Descend('a' - 'a')->ChildMask());
+
+  // Profile a 3x3 board through a solver, which owns its Trie. The board
+  // spells "tea" down its first column, but has no 'i' or 'p', so "ti" and
+  // "ap" are never visited.
+  st.AddWord("ape");
+  SimpleTrie* pst = new SimpleTrie;
+  pst->AddWord("tea");
+  pst->AddWord("tip");
+  pst->AddWord("ape");
+  Boggler3 solver(pst);
+  TrieProfile profile(pst, &solver);
+  assert(profile.AddBoard("teazzzzzz"));
+  assert(!profile.AddBoard("tea"));
+  assert(1 == profile.NumBoards());
+  SimpleTrie* pte = pst->Descend('t' - 'a');
+  assert(1 == profile.Visits(pst));
+  assert(1 == profile.Visits(pte));
+  assert(1 == profile.Visits(pte->Descend('e' - 'a')->Descend('a' - 'a')));
+  assert(0 == profile.Visits(pte->Descend('i' - 'a')));
+  assert(0 == profile.Visits(pst->Descend('a' - 'a')->Descend('p' - 'a')));
+
+  std::vector<const SimpleTrie*> hot;
+  profile.HotNodes(1 << 20, &hot);
+  assert(profile.NumVisitedNodes() == hot.size());
+  assert(pst == hot[0]);
+  profile.HotNodes(Trie::CompactNodeSize(*pst), &hot);
+  assert(1 == hot.size());
+
+  // A node is visited once per cell with its letter, so "a" outcounts the
+  // root. It still can't come before it.
+  SimpleTrie* pa = pst->Descend('a' - 'a');
+  assert(profile.AddBoard("aaaaaaaaa"));
+  assert(2 == profile.Visits(pst));
+  assert(10 == profile.Visits(pa));
+  profile.HotNodes(Trie::CompactNodeSize(*pst) + Trie::CompactNodeSize(*pa),
+                   &hot);
+  assert(2 == hot.size());
+  assert(pst == hot[0]);
+  assert(pa == hot[1]);
+
+  // Hot nodes come first, in order, and the rest follow.
+  SimpleTrie* tea = te->Descend('e' - 'a')->Descend('a' - 'a');
+  SimpleTrie* ti = te->Descend('i' - 'a');
+  hot.clear();
+  hot.push_back(tea);
+  hot.push_back(ti);
+  Trie* pt = Trie::CompactTrie(st, hot);
+  assert(pt->IsWord("tea"));
+  assert(pt->IsWord("tip"));
+  assert(pt->IsWord("ape"));
+  assert(!pt->IsWord("ti"));
+  Trie* pt_te = pt->Descend('t' - 'a');
+  Trie* pt_tea = pt_te->Descend('e' - 'a')->Descend('a' - 'a');
+  Trie* pt_ti = pt_te->Descend('i' - 'a');
+  assert((char*)pt_tea < (char*)pt_ti);
+  assert((char*)pt_ti < (char*)pt->Descend('a' - 'a'));
+  assert((char*)pt_ti < (char*)pt_te);
+  pt->Delete();
+
+  // Layouts survive a round trip through a file.
+  char layout_file[] = "/tmp/trie-layout.XXXXXX";
+  assert(-1 != mkstemp(layout_file));
+  hot.insert(hot.begin(), &st);
+  assert(TrieProfile::WriteLayout(layout_file, &st, hot));
+  std::vector<const SimpleTrie*> read;
+  assert(TrieProfile::ReadLayout(layout_file, &st, &read));
+  assert(read == hot);
+  assert(0 == remove(layout_file));
+
+  // Restrict to the words spelled with at most one 't' and 'e', and two 'a's
+  // and 'p's. "tip" needs an 'i'.
+  st.AddWord("papa");
+  st.AddWord("tat");
+  int max_uses[26] = { 0 };
+  max_uses['t' - 'a'] = max_uses['e' - 'a'] = 1;
+  max_uses['a' - 'a'] = max_uses['p' - 'a'] = 2;
+  SimpleTrie* r = st.Restrict(max_uses);
+  assert(3 == TrieUtils<SimpleTrie>::Size(r));
+  assert(TrieUtils<SimpleTrie>::FindWord(r, "tea"));
+  assert(TrieUtils<SimpleTrie>::FindWord(r, "ape"));
+  assert(TrieUtils<SimpleTrie>::FindWord(r, "papa"));
+  assert(!TrieUtils<SimpleTrie>::FindWord(r, "tat"));
+  assert(!r->Descend('t' - 'a')->StartsWord('i' - 'a'));  // no dead ends.
+  max_uses['p' - 'a'] = 0;
+  SimpleTrie* rr = r->Restrict(max_uses);
+  assert(1 == TrieUtils<SimpleTrie>::Size(rr));
+  delete rr;
+
+  // Each Trie owns the Arena its nodes come from. Chunks start small, so
+  // that a small Trie doesn't take much memory.
+  SimpleTrie* a = new SimpleTrie;
+  assert(0 == a->GetArena()->BytesAllocated());
+  a->AddWord("tea");
+  assert(a->Descend('t' - 'a')->GetArena() == a->GetArena());
+  assert(16 * sizeof(SimpleTrie) == a->GetArena()->BytesAllocated());
+  assert(r->GetArena() != st.GetArena());
+
+  // Tries built separately can be joined, with the root adopting the Arena
+  // the other nodes came from.
+  SimpleTrie::Arena* other = new SimpleTrie::Arena;
+  SimpleTrie* p = other->NewNode();
+  p->AddWord("ea");
+  a->GetArena()->Adopt(other);
+  a->SetChild('p' - 'a', p);
+  assert(2 == TrieUtils<SimpleTrie>::Size(a));
+  assert(TrieUtils<SimpleTrie>::FindWord(a, "pea"));
+  assert(32 * sizeof(SimpleTrie) == a->GetArena()->BytesAllocated());
+  delete a;
+  delete r;
+
+  // A Trie with more than the 10MB that CompactTrie() used to allow.
+  SimpleTrie* big = new SimpleTrie;
+  const char* kFiles[] = { "words", "twl.txt" };
+  char line[80];
+  for (int i = 0; i < 2; i++) {
+    FILE* wf = fopen(kFiles[i], "r");
+    assert(wf);
+    while (fscanf(wf, "%79s", line) == 1) big->AddWord(line);
+    fclose(wf);
+  }
+  Trie* bt = Trie::CompactTrie(*big);
+  assert(bt);
+  assert(bt->MemoryUsage() > (10 << 20));
+  assert(TrieUtils<SimpleTrie>::Size(big) == TrieUtils<Trie>::Size(bt));
+  assert(TrieUtils<SimpleTrie>::NumNodes(big) == TrieUtils<Trie>::NumNodes(bt));
+  assert(bt->IsWord("agriculture"));
+  assert(!bt->IsWord("agricultur"));
+  bt->Delete();
+  delete big;
+
   printf("%s: All tests passed!\n", argv[0]);
 }